@@ -7,22 +7,18 @@
 #include <inttypes.h>
 #include <queue>
 
-/* How to execute this example */
-enum class ExampleExecution
-{
-	NodeJSEventLoop_ExecutesNext,
-	SettlementThread_ExecutesNext
-};
-
 /* Event loop callback temporary storage */
 struct NextCallback
 {
-	AsBasicPromise<AsReactiveExecutor>* Promise;
+	AsPolymorphicPromise* Promise;
 	asIScriptFunction* Callback;
 };
 
-/* Context state globals */
-static ExampleExecution ExecutionPolicy = ExampleExecution::NodeJSEventLoop_ExecutesNext;
+/*
+	How to execute this example: reactive policy executes next
+	in event loop, direct policy executes next on settlement thread
+*/
+static uint8_t ExecutionPolicy = AsPolymorphicExecutor::Reactive;
 
 /* Thread utils */
 std::string GetThreadId()
@@ -80,7 +76,7 @@ void SetTimeoutNative(uint64_t Ms, asIScriptFunction* Callback)
 	std::thread([ThisContext, DelegateObject, Callback, Ms]()
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(Ms));
-		if (ExecutionPolicy == ExampleExecution::SettlementThread_ExecutesNext)
+		if (AsPolymorphicExecutor::GetPolicy(ThisContext) == AsPolymorphicExecutor::Direct)
 		{
 			/*
 				Callback will be executed in newly created context,
@@ -98,10 +94,10 @@ void SetTimeoutNative(uint64_t Ms, asIScriptFunction* Callback)
 			Engine->ReturnContext(Context);
             AsClearCallback(Callback);
 		}
-		else if (ExecutionPolicy == ExampleExecution::NodeJSEventLoop_ExecutesNext)
+		else
 		{
 			/* Callback will be executed in event loop */
-			AsReactiveExecutor()(nullptr, ThisContext, Callback);
+			AsPolymorphicExecutor::GetCallback(ThisContext)(nullptr, Callback);
 		}
 		asThreadCleanup();
 	}).detach();
@@ -111,58 +107,44 @@ void SetTimeoutNative(uint64_t Ms, asIScriptFunction* Callback)
 	Same as previous but promise will be returned, this is an example
 	when promise is settled within C++
 */
-void* SetTimeoutNativePromise(uint64_t Ms)
+AsPolymorphicPromise* SetTimeoutNativePromise(uint64_t Ms)
 {
-	void* Result = nullptr;
-	if (ExecutionPolicy == ExampleExecution::SettlementThread_ExecutesNext)
-		Result = AsDirectPromise::Create();
-	else if (ExecutionPolicy == ExampleExecution::NodeJSEventLoop_ExecutesNext)
-		Result = AsReactivePromise::Create();
-
+	/* Promise inherits executor policy of calling context */
+	AsPolymorphicPromise* Promise = AsPolymorphicPromise::Create();
 	PrintSetTimeout(Ms);
-	std::thread([Ms, Result]()
+	std::thread([Ms, Promise]()
 	{
 		std::this_thread::sleep_for(std::chrono::milliseconds(Ms));
 		PrintResolveTimeout(Ms); // Print as in script file
 
 		uint32_t Value = 1;
-		if (ExecutionPolicy == ExampleExecution::SettlementThread_ExecutesNext)
-		{
-			AsDirectPromise* Promise = (AsDirectPromise*)Result;
-			Promise->Store(&Value, asTYPEID_UINT32); // Settle the promise
-			/*
-				Must release, returned promise ref-count is automatically incremented,
-				in more complex environments additional logic may be required to maintain
-				valid promise lifetime (!)
-			*/
-			Promise->Release();
-		}
-		else if (ExecutionPolicy == ExampleExecution::NodeJSEventLoop_ExecutesNext)
-		{
-			AsReactivePromise* Promise = (AsReactivePromise*)Result;
-			Promise->Store(&Value, asTYPEID_UINT32);
-			Promise->Release();
-		}
+		Promise->Store(&Value, asTYPEID_UINT32); // Settle the promise
+		/*
+			Must release, returned promise ref-count is automatically incremented,
+			in more complex environments additional logic may be required to maintain
+			valid promise lifetime (!)
+		*/
+		Promise->Release();
 		asThreadCleanup();
 	}).detach();
 
-	return Result;
+	return Promise;
 }
 
 /* AngelScript to C++ promises */
-void AwaitPromiseBlocking(void* Promise)
+void AwaitPromiseBlocking(AsPolymorphicPromise* Promise)
 {
-	if (ExecutionPolicy == ExampleExecution::SettlementThread_ExecutesNext)
+	if (Promise->GetExecutorTag() == AsPolymorphicExecutor::Direct)
 	{
 		/*
 			Here we can block current thread because we know
 			that some other thread will resolve the promise 
 		*/
 		uint32_t Number = 0;
-		((AsDirectPromise*)Promise)->WaitIf()->Retrieve(&Number, asTYPEID_UINT32);
+		Promise->WaitIf()->Retrieve(&Number, asTYPEID_UINT32);
 		printf("  received number %i from script context (blocking)\n", Number);
 	}
-	else if (ExecutionPolicy == ExampleExecution::NodeJSEventLoop_ExecutesNext)
+	else
 	{
 		asIScriptContext* Context = asGetActiveContext();
 		PROMISE_ASSERT(Context != nullptr, "cannot access current context");
@@ -170,48 +152,27 @@ void AwaitPromiseBlocking(void* Promise)
 		printf("  !!! cannot do blocking await while using event loop (expected)\n");
 	}
 }
-void AwaitPromiseNonBlocking(void* PromiseContext)
+void AwaitPromiseNonBlocking(AsPolymorphicPromise* Promise)
 {
+	/* If promise is still pending the we suspend the context */
 	auto* Context = asGetActiveContext();
-	if (ExecutionPolicy == ExampleExecution::SettlementThread_ExecutesNext)
-	{
-		/* If promise is still pending the we suspend the context */
-		AsDirectPromise* Promise = (AsDirectPromise*)PromiseContext;
-		if (Context != nullptr && Promise->IsPending())
-			PROMISE_CHECK(Context->Suspend());
-		else
-			Context = nullptr;
+	if (Context != nullptr && Promise->IsPending())
+		PROMISE_CHECK(Context->Suspend());
+	else
+		Context = nullptr;
 
-		Promise->When([Context](AsDirectPromise* Promise)
-		{
-			uint32_t Number = 0;
-			Promise->Retrieve(&Number, asTYPEID_UINT32);
-			printf("  received number %i from script context (non-blocking)\n", Number);
-			/*
-				If promise was pending then we resume the context otherwise this callback
-				was called in-place
-			*/
-			if (Context != nullptr)
-				PROMISE_CHECK(Context->Execute());
-		});
-	}
-	else if (ExecutionPolicy == ExampleExecution::NodeJSEventLoop_ExecutesNext)
+	Promise->When([Context](AsPolymorphicPromise* Promise)
 	{
-		AsReactivePromise* Promise = (AsReactivePromise*)PromiseContext;
-		if (Context != nullptr && Promise->IsPending())
-			PROMISE_CHECK(Context->Suspend());
-		else
-			Context = nullptr;
-
-		Promise->When([Context](AsReactivePromise* Promise)
-		{
-			uint32_t Number = 0;
-			Promise->Retrieve(&Number, asTYPEID_UINT32);
-			printf("  received number %i from script context (non-blocking)\n", Number);
-			if (Context != nullptr)
-				PROMISE_CHECK(Context->Execute());
-		});
-	}
+		uint32_t Number = 0;
+		Promise->Retrieve(&Number, asTYPEID_UINT32);
+		printf("  received number %i from script context (non-blocking)\n", Number);
+		/*
+			If promise was pending then we resume the context otherwise this callback
+			was called in-place
+		*/
+		if (Context != nullptr)
+			PROMISE_CHECK(Context->Execute());
+	});
 }
 
 /* Compiler status logger */
@@ -233,11 +194,9 @@ int main(int argc, char* argv[])
 	PROMISE_CHECK(Engine->SetMessageCallback(asFUNCTION(Log), 0, asCALL_CDECL));
 	PROMISE_CHECK(Engine->SetEngineProperty(asEP_USE_CHARACTER_LITERALS, 1));
 	
-	/* Interface registration */
-	if (ExecutionPolicy == ExampleExecution::SettlementThread_ExecutesNext)
-		AsDirectPromise::Register(Engine);
-	else if (ExecutionPolicy == ExampleExecution::NodeJSEventLoop_ExecutesNext)
-		AsReactivePromise::Register(Engine);
+	/* Interface registration, policy may also be chosen per context or per promise */
+	AsPolymorphicPromise::Register(Engine);
+	AsPolymorphicExecutor::SetPolicy(Engine, ExecutionPolicy);
 	PROMISE_CHECK(Engine->RegisterFuncdef("void timer_callback()"));
 	PROMISE_CHECK(Engine->RegisterGlobalFunction("uint64 get_milliseconds()", asFUNCTION(GetMilliseconds), asCALL_CDECL));
 	PROMISE_CHECK(Engine->RegisterGlobalFunction("void print_resolve_timeout()", asFUNCTION(PrintResolveTimeout), asCALL_CDECL));
@@ -276,7 +235,7 @@ int main(int argc, char* argv[])
 
 	/* Context initialization */
 	asIScriptContext* Context = Engine->RequestContext();
-	if (ExecutionPolicy == ExampleExecution::SettlementThread_ExecutesNext)
+	if (ExecutionPolicy == AsPolymorphicExecutor::Direct)
 	{
 		PROMISE_CHECK(Context->Prepare(Main));
 		int R = Context->Execute();
@@ -284,13 +243,13 @@ int main(int argc, char* argv[])
 		while (IsAsyncContextBusy(Context))
 			std::this_thread::sleep_for(std::chrono::milliseconds(10));
 	}
-	else if (ExecutionPolicy == ExampleExecution::NodeJSEventLoop_ExecutesNext)
+	else
 	{
 		/* Event loop state */
 		std::queue<NextCallback> Queue;
 		std::condition_variable Condition;
 		std::mutex Mutex;
-		AsReactiveExecutor::ReactiveCallback Notify = [&Mutex, &Condition, &Queue](AsReactivePromise* Promise, asIScriptFunction* Callback)
+		AsPolymorphicExecutor::ReactiveCallback Notify = [&Mutex, &Condition, &Queue](AsPolymorphicPromise* Promise, asIScriptFunction* Callback)
 		{
 			std::unique_lock<std::mutex> Unique(Mutex);
 			Queue.push({ Promise, Callback });
@@ -298,7 +257,8 @@ int main(int argc, char* argv[])
 		};
 
 		/* Event loop setup */
-		AsReactiveExecutor::SetCallback(Context, &Notify);
+		AsPolymorphicExecutor::SetCallback(Context, &Notify);
+		AsPolymorphicExecutor::SetCallback(Engine, &Notify);
 
 		/* Push main function onto the stack */
 		Main->AddRef();
@@ -321,6 +281,8 @@ int main(int argc, char* argv[])
 				asIScriptContext* ExecutingContext = Context;
 				if (Next.Callback != nullptr && ExecutingContext->GetState() == asEXECUTION_SUSPENDED)
 					ExecutingContext = Engine->RequestContext();
+				else if (Next.Callback == nullptr && Next.Promise != nullptr)
+					ExecutingContext = Next.Promise->GetContext();
 				
 				/* Negate mutex while executing the callback */
 				Unique.unlock();
@@ -331,20 +293,20 @@ int main(int argc, char* argv[])
 					if (Next.Promise)
 						PROMISE_CHECK(ExecutingContext->SetArgObject(0, Next.Promise));
 				}
-				int R = ExecutingContext->Execute();
+				int R = AsExecuteContext(ExecutingContext);
 				Unique.lock();
 
-				/* Release associated state */
+				/* Release associated state, contexts of spawned functions are returned by spawner */
 				if (Next.Callback != nullptr)
 					AsClearCallback(Next.Callback);
-				if (ExecutingContext != Context)
+				if (Next.Callback != nullptr && ExecutingContext != Context)
 					Engine->ReturnContext(ExecutingContext);
 
 				/* Check if we may continue execute callbacks */
 				if (R == asEXECUTION_SUSPENDED)
 				{
 					/* Coroutines inside callbacks require a lot more complex logic */
-					PROMISE_ASSERT(ExecutingContext == Context, "this event loop does not allow coroutine usage inside callbacks");
+					PROMISE_ASSERT(Next.Callback == nullptr || ExecutingContext == Context, "this event loop does not allow coroutine usage inside callbacks");
 					break;
 				}
 				else if (R == asEXECUTION_FINISHED)
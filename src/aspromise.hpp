@@ -10,10 +10,68 @@
 #define PROMISE_WHEN "when" // promise callback function
 #define PROMISE_EVENT "when_callback" // promise funcdef name
 #define PROMISE_PENDING "pending" // promise status checker
+#define PROMISE_REJECT "reject" // promise failure setter function
+#define PROMISE_FAILED "failed" // promise failure checker
+#define PROMISE_ERRORCODE "error_code" // promise failure code getter
+#define PROMISE_ERRORDETAIL "error_detail" // promise failure detail getter
+#define PROMISE_UNWRAPOR "unwrap_or" // promise getter function that never throws
 #define PROMISE_AWAIT "co_await" // keyword for await (C++20 coroutines one love)
+#define PROMISE_MUTEX "async_mutex" // coroutine mutex type
+#define PROMISE_SEMAPHORE "async_semaphore" // coroutine semaphore type
+#define PROMISE_EVENTTYPE "async_event" // coroutine event type
+#define PROMISE_BARRIER "async_barrier" // coroutine barrier type
+#define PROMISE_SPAWN "spawn" // concurrent script function starter
+#define PROMISE_TASKGROUP "task_group" // spawned functions group type
+#define PROMISE_SLEEP "sleep" // virtual time timer function
+#define PROMISE_VIRTUALTIME "virtual_time" // virtual time getter function
 #define PROMISE_USERID 559 // promise user data identifier (any value)
 #define PROMISE_NULLID -1 // empty promise type id
 #define PROMISE_CALLBACKS true // allow <when> listener
+#define PROMISE_MAP "map" // promise inline transform function
+#define PROMISE_THEN "then" // promise inline continuation function
+#define PROMISE_MAPEVENT "map_callback" // promise transform funcdef name
+#define PROMISE_CONTINUATION_ERROR -1 // error code of rejection caused by failed continuation
+#define PROMISE_BINDING_ERROR -2 // error code of rejection caused by exception in async native function
+#define PROMISE_SPAWN_ERROR -3 // error code of rejection caused by exception in spawned function
+#define PROMISE_CACHE_ERROR -4 // error code of rejection caused by failed cache loader
+#define PROMISE_PARALLEL_ERROR -5 // error code of rejection caused by exception in parallel callback
+#define PROMISE_TRACING false // record promise lifecycle events (compiled out by default)
+#define PROMISE_TRACE_CAPACITY 16384 // trace events kept per thread before dropping
+#define PROMISE_METRICS false // collect runtime counters and await site histograms
+#define PROMISE_METRICS_BUCKETS 32 // latency histogram buckets (log2 of microseconds)
+#define PROMISE_METRICS_SHARDS 16 // await site map shards
+#define PROMISE_ADMISSION false // track suspended contexts for admission control
+#define PROMISE_ADMISSION_FRAME_SIZE 256 // estimated bytes per suspended call frame
+#define PROMISE_REGISTRY false // keep registry of pending promises for introspection and watchdog
+#define PROMISE_REGISTRY_SHARDS 16 // registry shards (by creating thread)
+#define PROMISE_REGISTRY_CHUNK 256 // registry slots allocated at once per shard
+#define PROMISE_FIBERS false // allow native functions to await promises on pooled fiber stacks (posix ucontext)
+#define PROMISE_FIBER_STACK 262144 // usable bytes of fiber stack, guard page is added below
+#define PROMISE_FIBER_POOL 64 // idle fibers kept by fiber pool
+#define PROMISE_PARALLEL false // register parallel_for and parallel_map on blocking pool (requires scriptarray add-on)
+#define PROMISE_PARALLELFOR "parallel_for" // parallel loop function, it's callback funcdef gets <_callback> postfix
+#define PROMISE_PARALLELMAP "parallel_map" // parallel array transform method, it's callback funcdef gets <_callback> postfix
+#define PROMISE_FILES false // register async file module (requires scriptarray add-on)
+#define PROMISE_FILE "async_file" // async file handle type
+#define PROMISE_FILE_ENTRIES 256 // io_uring submission queue size
+#define PROMISE_FILE_CHUNK 4096 // first read size of files that do not report their size
+#define PROMISE_SOCKETS false // register socket module on epoll reactor (linux, requires scriptarray add-on)
+#define PROMISE_SOCKET "async_socket" // async socket type
+#define PROMISE_REACTOR_EVENTS 64 // readiness events handled per reactor wait
+#define PROMISE_PROCESSES false // register subprocess module on epoll reactor (linux, requires scriptarray and string add-ons)
+#define PROMISE_PROCESS "async_process" // streaming subprocess type
+#define PROMISE_PROCESSRESULT "process_result" // captured subprocess output type
+#define PROMISE_BRIDGE false // settle promises from other processes through shared memory (linux)
+#define PROMISE_BRIDGE_ENDPOINTS 16 // max processes receiving through one bridge region
+#define PROMISE_EXECUTOR_POLICIES 8 // resume policies of polymorphic executor
+#define PROMISE_CACHE false // register single-flight async cache (requires string add-on)
+#define PROMISE_CACHENAME "async_cache" // async cache type
+#define PROMISE_CACHE_SHARDS 16 // async cache shards, capacity is split between them
+#define PROMISE_GC_SCHEDULER false // run incremental garbage collection in event loop slack time
+#define PROMISE_GC_BUDGET 1000 // microseconds of garbage collection per idle call
+#define PROMISE_GC_THRESHOLD 65536 // tracked objects count that forces full cycle
+#define PROMISE_ENGINES false // keep pool of script engines set up ahead of time
+#define PROMISE_ENGINES_IDLE 4 // ready engines kept by engine pool
 #endif
 #ifndef NDEBUG
 #define PROMISE_ASSERT(Expression, Message) assert((Expression) && Message)
@@ -26,9 +84,32 @@
 #include <angelscript.h>
 #endif
 #include <assert.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <limits>
 #include <mutex>
+#include <condition_variable>
 #include <cctype>
 #include <functional>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+/* Steady clock time (microseconds by default), shared time source of timers and bookkeeping */
+template <typename Units = std::chrono::microseconds>
+static uint64_t AsGetTimestamp()
+{
+	return (uint64_t)std::chrono::duration_cast<Units>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+/* Append one sample in plain text exposition format (prometheus compatible), labels are written as is */
+static void AsExportSample(std::string& Result, const char* Name, uint64_t Value, const std::string& Labels = std::string())
+{
+	Result += Name;
+	if (!Labels.empty())
+		Result += "{" + Labels + "}";
+	Result += " " + std::to_string(Value) + "\n";
+}
 #ifndef AS_PROMISE_NO_HELPERS
 /* Helper function to cleanup the script function */
 static void AsClearCallback(asIScriptFunction* Callback)
@@ -48,538 +129,6786 @@ static bool IsAsyncContextBusy(asIScriptContext* Context)
 {
 	return IsAsyncContextPending(Context) || Context->GetState() == asEXECUTION_ACTIVE;
 }
+/* Hook that is called once when context executed through AsExecuteContext stops being suspended */
+struct AsContextHook
+{
+	void(*Finish)(AsContextHook* Hook, asIScriptContext* Context, int Status) = nullptr;
+};
+#if PROMISE_METRICS
+static void AsMeasureResume(asIScriptContext* Context);
+#endif
+/* Helper function to execute or resume the context, fires it's finish hook if any */
+static int AsExecuteContext(asIScriptContext* Context)
+{
+#if PROMISE_METRICS
+	AsMeasureResume(Context);
 #endif
+	int Status = Context->Execute();
+	if (Status == asEXECUTION_SUSPENDED)
+		return Status;
 
+	AsContextHook* Hook = (AsContextHook*)Context->GetUserData(PROMISE_USERID + 5);
+	if (Hook != nullptr)
+	{
+		Context->SetUserData(nullptr, PROMISE_USERID + 5);
+		Hook->Finish(Hook, Context, Status);
+	}
+	return Status;
+}
+#ifdef SCRIPTARRAY_H
+/* Release array<uint8> type cached in engine */
+static void AsReleaseByteArrayType(asIScriptEngine* Engine)
+{
+	asITypeInfo* Type = (asITypeInfo*)Engine->GetUserData(PROMISE_USERID + 10);
+	if (Type != nullptr)
+		Type->Release();
+}
+/* Helper function to create array<uint8> of given size, buffer is filled in-place by I/O */
+static CScriptArray* AsCreateByteArray(asIScriptEngine* Engine, asUINT Size)
+{
+	asITypeInfo* Type = (asITypeInfo*)Engine->GetUserData(PROMISE_USERID + 10);
+	if (Type != nullptr)
+		return CScriptArray::Create(Type, Size);
+
+	Type = Engine->GetTypeInfoByDecl("array<uint8>");
+	PROMISE_ASSERT(Type != nullptr, "array<uint8> should be registered");
+	Type->AddRef();
+	Engine->SetEngineUserDataCleanupCallback(&AsReleaseByteArrayType, PROMISE_USERID + 10);
+	asITypeInfo* Previous = (asITypeInfo*)Engine->SetUserData(Type, PROMISE_USERID + 10);
+	if (Previous != nullptr)
+		Previous->Release();
+	return CScriptArray::Create(Type, Size);
+}
+/* Helper function to copy array<uint8> contents when I/O is submitted, script may change or resize the array while I/O runs */
+static std::shared_ptr<std::vector<uint8_t>> AsCopyByteArray(const CScriptArray& Source)
+{
+	const uint8_t* Data = (const uint8_t*)((CScriptArray&)Source).GetBuffer();
+	return std::make_shared<std::vector<uint8_t>>(Data, Data + Source.GetSize());
+}
+#endif
+#endif
+#if PROMISE_TRACING
+#include <stdio.h>
+#include <chrono>
 /*
-	Basic promise class that can be used for non-blocking asynchronous operation
-	data exchange between AngelScript and C++ and vice-versa.
+	Promise lifecycle tracer, every thread writes events into it's own
+	single producer ring buffer so that recording never takes a lock,
+	flush drains all rings into chrome trace event json file which
+	is also accepted by Perfetto UI (ui.perfetto.dev)
 */
-template <typename Executor>
-class AsBasicPromise
+class AsPromiseTracer
 {
-private:
-	/* Basically used from <any> class */
-	struct Dynamic
+public:
+	enum class Event : uint8_t
 	{
-		union
-		{
-			asINT64 Integer;
-			double Number;
-			void* Object;
-		};
-
-		int TypeId = PROMISE_NULLID;
+		Create,
+		Store,
+		Suspend,
+		Resume,
+		Callback
 	};
-#if PROMISE_CALLBACKS
-	/* Callbacks storage */
-	struct
+
+	struct Record
 	{
-		std::function<void(AsBasicPromise<Executor>*)> Native;
-		asIScriptFunction* Wrapper = nullptr;
-	} Callbacks;
-#else
-	std::condition_variable Ready;
-#endif
+		uint64_t Timestamp;
+		uint64_t PromiseId;
+		uint64_t ContextId;
+		uint32_t ThreadId;
+		Event Type;
+	};
+
 private:
-	asIScriptEngine* Engine;
-	asIScriptContext* Context;
-	std::atomic<uint32_t> RefCount;
-	std::atomic<uint32_t> RefMark; 
-	std::mutex Update;
-	Dynamic Value;
+	struct Buffer
+	{
+		Record Records[PROMISE_TRACE_CAPACITY];
+		std::atomic<uint64_t> Head;
+		std::atomic<uint64_t> Tail;
+		std::atomic<uint64_t> Dropped;
+		std::atomic<bool> Owned;
+		uint32_t ThreadId;
+		Buffer* Next;
+	};
 
-public:
-	/* Thread safe release */
-	void Release()
+	struct Owner
 	{
-		PROMISE_ASSERT(RefCount > 0, "promise is already released");
-		RefMark = 0;
-		if (!--RefCount)
+		Buffer* Target = nullptr;
+
+		~Owner()
 		{
-			ReleaseReferences(nullptr);
-			this->~AsBasicPromise();
-			asFreeMem((void*)this);
+			if (Target != nullptr)
+				Target->Owned = false;
 		}
-	}
-	/* Thread safe add reference */
-	void AddRef()
+	};
+
+public:
+	/* Record an event from current thread, lock-free, drops events when buffer is full */
+	static void Push(Event Type, void* Promise, void* Context)
 	{
-		PROMISE_ASSERT(RefCount < std::numeric_limits<uint32_t>::max(), "too many references to this promise");
-		RefMark = 0;
-		++RefCount;
+		Buffer* Target = GetThreadBuffer();
+		uint64_t Head = Target->Head.load(std::memory_order_relaxed);
+		if (Head - Target->Tail.load(std::memory_order_acquire) >= PROMISE_TRACE_CAPACITY)
+		{
+			Target->Dropped.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Record& Next = Target->Records[Head % PROMISE_TRACE_CAPACITY];
+		Next.Timestamp = AsGetTimestamp<std::chrono::nanoseconds>();
+		Next.PromiseId = (uint64_t)(uintptr_t)Promise;
+		Next.ContextId = (uint64_t)(uintptr_t)Context;
+		Next.ThreadId = Target->ThreadId;
+		Next.Type = Type;
+		Target->Head.store(Head + 1, std::memory_order_release);
 	}
-	/* For garbage collector to detect references */
-	void EnumReferences(asIScriptEngine* OtherEngine)
+	/* Drain all thread buffers, records are passed to callback in per-thread order */
+	static uint64_t Drain(const std::function<void(const Record&)>& Callback)
 	{
-		if (Value.Object != nullptr && (Value.TypeId & asTYPEID_MASK_OBJECT))
+		std::unique_lock<std::mutex> Unique(GetFlushMutex());
+		uint64_t Dropped = 0;
+		for (Buffer* Next = GetBuffers().load(std::memory_order_acquire); Next != nullptr; Next = Next->Next)
 		{
-			asITypeInfo* SubType = Engine->GetTypeInfoById(Value.TypeId);
-			if ((SubType->GetFlags() & asOBJ_REF))
-				OtherEngine->GCEnumCallback(Value.Object);
-			else if ((SubType->GetFlags() & asOBJ_VALUE) && (SubType->GetFlags() & asOBJ_GC))
-				Engine->ForwardGCEnumReferences(Value.Object, SubType);
+			uint64_t Head = Next->Head.load(std::memory_order_acquire);
+			uint64_t Tail = Next->Tail.load(std::memory_order_relaxed);
+			while (Tail < Head)
+				Callback(Next->Records[Tail++ % PROMISE_TRACE_CAPACITY]);
 
-			asITypeInfo* Type = OtherEngine->GetTypeInfoById(Value.TypeId);
-			if (Type != nullptr)
-				OtherEngine->GCEnumCallback(Type);
-		}
-#if PROMISE_CALLBACKS
-		if (Callbacks.Wrapper != nullptr)
-		{
-			void* DelegateObject = Callbacks.Wrapper->GetDelegateObject();
-			if (DelegateObject != nullptr)
-				OtherEngine->GCEnumCallback(DelegateObject);
-			OtherEngine->GCEnumCallback(Callbacks.Wrapper);
+			Next->Tail.store(Tail, std::memory_order_release);
+			Dropped += Next->Dropped.exchange(0, std::memory_order_relaxed);
 		}
-#endif
+
+		return Dropped;
 	}
-	/* For garbage collector to release references */
-	void ReleaseReferences(asIScriptEngine*)
+	/*
+		Flush all recorded events into chrome trace event json file,
+		suspend and resume events are paired into async slices using
+		promise id so that await chains are visible in timeline
+	*/
+	static bool Flush(const char* Path)
 	{
-		if (Value.TypeId & asTYPEID_MASK_OBJECT)
-		{
-			asITypeInfo* Type = Engine->GetTypeInfoById(Value.TypeId);
-			Engine->ReleaseScriptObject(Value.Object, Type);
-			if (Type != nullptr)
-				Type->Release();
-			Clean();
-		}
-#if PROMISE_CALLBACKS
-		if (Callbacks.Wrapper != nullptr)
+		PROMISE_ASSERT(Path != nullptr, "trace path should not be null");
+		FILE* Stream = fopen(Path, "wb");
+		if (!Stream)
+			return false;
+
+		bool Comma = false;
+		fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", Stream);
+		uint64_t Dropped = Drain([Stream, &Comma](const Record& Next)
 		{
-			AsClearCallback(Callbacks.Wrapper);
-			Callbacks.Wrapper = nullptr;
-		}
-#endif
+			static const char* Names[] = { "create", "store", "await", "await", "callback" };
+			const char* Phase = "i";
+			if (Next.Type == Event::Suspend)
+				Phase = "b";
+			else if (Next.Type == Event::Resume)
+				Phase = "e";
+
+			fprintf(Stream, "%s\n{\"name\":\"%s\",\"cat\":\"promise\",\"ph\":\"%s\",\"s\":\"t\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"id\":\"0x%llx\",\"args\":{\"promise\":\"0x%llx\",\"context\":\"0x%llx\"}}",
+				Comma ? "," : "", Names[(uint8_t)Next.Type], Phase, (unsigned int)Next.ThreadId, (double)Next.Timestamp / 1000.0,
+				(unsigned long long)Next.PromiseId, (unsigned long long)Next.PromiseId, (unsigned long long)Next.ContextId);
+			Comma = true;
+		});
+		fprintf(Stream, "\n],\"otherData\":{\"dropped\":%llu}}\n", (unsigned long long)Dropped);
+		return fclose(Stream) == 0;
 	}
-	/* For garbage collector to mark */
-	void MarkRef()
+
+private:
+	/* Find or allocate a buffer for current thread, buffers of finished threads are reused */
+	static Buffer* GetThreadBuffer()
 	{
-		RefMark = 0;
+		static thread_local Owner Local;
+		if (Local.Target != nullptr)
+			return Local.Target;
+
+		std::atomic<Buffer*>& Buffers = GetBuffers();
+		for (Buffer* Next = Buffers.load(std::memory_order_acquire); Next != nullptr; Next = Next->Next)
+		{
+			bool Owned = false;
+			if (Next->Owned.compare_exchange_strong(Owned, true))
+			{
+				Next->ThreadId = GetThreadCounter()++;
+				Local.Target = Next;
+				return Next;
+			}
+		}
+
+		Buffer* Target = new(asAllocMem(sizeof(Buffer))) Buffer();
+		Target->Head = 0;
+		Target->Tail = 0;
+		Target->Dropped = 0;
+		Target->Owned = true;
+		Target->ThreadId = GetThreadCounter()++;
+		Target->Next = Buffers.load(std::memory_order_relaxed);
+		while (!Buffers.compare_exchange_weak(Target->Next, Target, std::memory_order_release, std::memory_order_relaxed));
+		Local.Target = Target;
+		return Target;
 	}
-	/* For garbage collector to check mark */
-	bool IsRefMarked()
+	static std::atomic<Buffer*>& GetBuffers()
 	{
-		return RefMark == 1;
+		static std::atomic<Buffer*> Buffers(nullptr);
+		return Buffers;
 	}
-	/* For garbage collector to check reference count */
-	uint32_t GetRefCount()
+	static std::atomic<uint32_t>& GetThreadCounter()
 	{
-		return RefCount;
+		static std::atomic<uint32_t> Counter(1);
+		return Counter;
 	}
-	/* Receive stored type id of future value */
-	int GetTypeIdOfObject()
+	static std::mutex& GetFlushMutex()
 	{
-		return Value.TypeId;
+		static std::mutex Mutex;
+		return Mutex;
 	}
-	/* Provide a native callback that should be fired when promise will be settled */
-	void When(std::function<void(AsBasicPromise<Executor>*)>&& NewCallback)
-	{
-#if PROMISE_CALLBACKS
-		std::unique_lock<std::mutex> Unique(Update);
-		Callbacks.Native = std::move(NewCallback);
-		if (Callbacks.Native && !IsPending())
-		{
-			auto Callback = std::move(Callbacks.Native);
-			Unique.unlock();
-			Callback(this);
-		}
+};
+#define PROMISE_TRACE(Type, Promise, Context) AsPromiseTracer::Push(AsPromiseTracer::Event::Type, (void*)(Promise), (void*)(Context))
 #else
-		PROMISE_ASSERT(false, "native callback binder for <when> is not allowed");
+#define PROMISE_TRACE(Type, Promise, Context)
 #endif
-	}
-	/* Provide a script callback that should be fired when promise will be settled */
-	void When(asIScriptFunction* NewCallback)
+#if PROMISE_METRICS
+#include <chrono>
+#include <string>
+#include <vector>
+#include <unordered_map>
+/*
+	Promise runtime metrics, counters are relaxed atomics that
+	can be scraped at any moment, await sites are aggregated per
+	script function declaration, section and line number of <yield>
+	suspension, so sites never refer to functions that may be freed
+*/
+class AsPromiseMetrics
+{
+public:
+	/* Log2 histogram of microseconds, bucket N holds values below 2^(N + 1) */
+	struct Histogram
 	{
-#if PROMISE_CALLBACKS
-		std::unique_lock<std::mutex> Unique(Update);
-		if (Callbacks.Wrapper != nullptr)
-			AsClearCallback(Callbacks.Wrapper);
+		std::atomic<uint64_t> Buckets[PROMISE_METRICS_BUCKETS];
+		std::atomic<uint64_t> Count;
+		std::atomic<uint64_t> Sum;
 
-		Callbacks.Wrapper = NewCallback;
-		if (Callbacks.Wrapper != nullptr)
+		Histogram() : Count(0), Sum(0)
 		{
-			void* DelegateObject = Callbacks.Wrapper->GetDelegateObject();
-			if (DelegateObject != nullptr)
-				Context->GetEngine()->AddRefScriptObject(DelegateObject, Callbacks.Wrapper->GetDelegateObjectType());
+			for (auto& Bucket : Buckets)
+				Bucket = 0;
 		}
+		void Push(uint64_t Microseconds)
+		{
+			size_t Index = 0;
+			while (Index + 1 < PROMISE_METRICS_BUCKETS && (Microseconds >> (Index + 1)) > 0)
+				++Index;
 
-		if (Callbacks.Wrapper != nullptr && !IsPending())
+			Buckets[Index].fetch_add(1, std::memory_order_relaxed);
+			Count.fetch_add(1, std::memory_order_relaxed);
+			Sum.fetch_add(Microseconds, std::memory_order_relaxed);
+		}
+		/* Upper bound of a bucket containing requested quantile (0.0 - 1.0) */
+		uint64_t Quantile(double Value) const
 		{
-			Callbacks.Wrapper = nullptr;
-			Unique.unlock();
-			Executor()(this, Context, NewCallback);
+			uint64_t Total = Count.load(std::memory_order_relaxed), Current = 0;
+			uint64_t Target = (uint64_t)((double)Total * Value);
+			for (size_t i = 0; i < PROMISE_METRICS_BUCKETS; i++)
+			{
+				Current += Buckets[i].load(std::memory_order_relaxed);
+				if (Current > Target)
+					return (uint64_t)2 << i;
+			}
+
+			return Total > 0 ? (uint64_t)2 << (PROMISE_METRICS_BUCKETS - 1) : 0;
 		}
-#else
-		PROMISE_ASSERT(false, "script callback binder for <when> is not allowed");
-#endif
-	}
-	/*
-		Thread safe store function, this is used as promise resolver function,
-		will either only store the result or store result and execute callback
-		that will resume suspended context and then release the promise (won't destroy)
-	*/
-	void Store(void* RefPointer, int RefTypeId)
+	};
+
+	/* Script location where context was suspended by <yield> */
+	struct Site
 	{
-		std::unique_lock<std::mutex> Unique(Update);
-		PROMISE_ASSERT(Value.TypeId == PROMISE_NULLID, "promise should be settled only once");
-		PROMISE_ASSERT(RefPointer != nullptr || RefTypeId == asTYPEID_VOID, "input pointer should not be null");
-		PROMISE_ASSERT(Engine != nullptr, "promise is malformed (engine is null)");
-		PROMISE_ASSERT(Context != nullptr, "promise is malformed (context is null)");
+		std::string Function;
+		std::string Section;
+		int Line = 0;
+		Histogram Suspension;
+	};
 
-		if (Value.TypeId != PROMISE_NULLID)
-		{
-			asIScriptContext* ThisContext = asGetActiveContext();
-			if (!ThisContext)
-				ThisContext = Context;
-			ThisContext->SetException("promise is already fulfilled");
-			return;
-		}
+	/* Suspension of one context, kept in context user data until it is resumed */
+	struct Await
+	{
+		Site* Location = nullptr;
+		uint64_t SuspendTime = 0;
+		uint64_t SettleTime = 0;
+		bool Suspended = false;
+	};
 
-		if ((RefTypeId & asTYPEID_MASK_OBJECT))
+	struct Counters
+	{
+		std::atomic<uint64_t> Created;
+		std::atomic<uint64_t> Destroyed;
+		std::atomic<uint64_t> Settled;
+		std::atomic<uint64_t> Suspended;
+		std::atomic<uint64_t> Resumed;
+		std::atomic<uint64_t> Callbacks;
+		Histogram SettleToResume;
+
+		Counters() : Created(0), Destroyed(0), Settled(0), Suspended(0), Resumed(0), Callbacks(0)
 		{
-			asITypeInfo* Type = Engine->GetTypeInfoById(RefTypeId);
-			if (Type != nullptr)
-				Type->AddRef();
 		}
+	};
+
+private:
+	struct Location
+	{
+		std::string Function;
+		std::string Section;
+		int Line;
 
-		Value.TypeId = RefTypeId;
-		if (Value.TypeId & asTYPEID_OBJHANDLE)
+		bool operator== (const Location& Other) const
 		{
-			Value.Object = *(void**)RefPointer;
+			return Line == Other.Line && Function == Other.Function && Section == Other.Section;
 		}
-		else if (Value.TypeId & asTYPEID_MASK_OBJECT)
+	};
+
+	struct LocationHash
+	{
+		size_t operator()(const Location& Value) const
 		{
-			Value.Object = Engine->CreateScriptObjectCopy(RefPointer, Engine->GetTypeInfoById(Value.TypeId));
+			return std::hash<std::string>()(Value.Function) ^ (std::hash<std::string>()(Value.Section) * 31) ^ (std::hash<int>()(Value.Line) * 0x9e3779b97f4a7c15ull);
 		}
-		else if (RefPointer != nullptr)
+	};
+
+	struct Shard
+	{
+		std::mutex Mutex;
+		std::unordered_map<Location, Site*, LocationHash> Sites;
+	};
+
+private:
+	Counters Values;
+	Shard Shards[PROMISE_METRICS_SHARDS];
+
+public:
+	~AsPromiseMetrics()
+	{
+		for (auto& Next : Shards)
 		{
-			Value.Integer = 0;
-			int Size = Engine->GetSizeOfPrimitiveType(Value.TypeId);
-			memcpy(&Value.Integer, RefPointer, Size);
+			for (auto& Item : Next.Sites)
+				delete Item.second;
 		}
+	}
+	/* Find or create an await site for current script location */
+	Site* GetSite(asIScriptContext* Context)
+	{
+		const char* Section = nullptr;
+		asIScriptFunction* Function = Context->GetFunction(0);
+		int Line = Context->GetLineNumber(0, nullptr, &Section);
+		Location Key = { Function ? Function->GetDeclaration(true, true) : "?", Section ? Section : "?", Line };
+		Shard& Target = Shards[LocationHash()(Key) % PROMISE_METRICS_SHARDS];
 
-		bool SuspendOwned = Context->GetUserData(PROMISE_USERID) == (void*)this;
-		if (SuspendOwned)
-			Context->SetUserData(nullptr, PROMISE_USERID);
-
-		bool WantsResume = (Context->GetState() == asEXECUTION_SUSPENDED && SuspendOwned);
-#if PROMISE_CALLBACKS
-		auto NativeCallback = std::move(Callbacks.Native);
-		auto* WrapperCallback = Callbacks.Wrapper;
-		Callbacks.Wrapper = nullptr;
-		Unique.unlock();
+		std::unique_lock<std::mutex> Unique(Target.Mutex);
+		Site*& Result = Target.Sites[Key];
+		if (Result != nullptr)
+			return Result;
 
-		if (NativeCallback != nullptr)
-			NativeCallback(this);
-		
-		if (WrapperCallback != nullptr)
-			Executor()(this, Context, WrapperCallback);
-#else
-		Ready.notify_all();
-		Unique.unlock();
-#endif
-		if (WantsResume)
-			Executor()(this, Context);
+		Result = new Site();
+		Result->Function = Key.Function;
+		Result->Section = Key.Section;
+		Result->Line = Key.Line;
+		return Result;
 	}
-	/* Thread safe store function, a little easier for C++ usage */
-	void Store(void* RefPointer, const char* TypeName)
+	/* Remember where and when context was suspended, counts it as suspended until it is woken or destroyed */
+	void Suspend(asIScriptContext* Context)
 	{
-		PROMISE_ASSERT(Engine != nullptr, "promise is malformed (engine is null)");
-		PROMISE_ASSERT(TypeName != nullptr, "typename should not be null");
-		Store(RefPointer, Engine->GetTypeIdByDecl(TypeName));
+		Await* Target = GetAwait(Context, true);
+		Target->Location = GetSite(Context);
+		Target->SuspendTime = AsGetTimestamp();
+		Target->SettleTime = 0;
+		if (!Target->Suspended)
+		{
+			Target->Suspended = true;
+			Values.Suspended.fetch_add(1, std::memory_order_relaxed);
+		}
 	}
-	/* Thread safe store function, for promise<void> */
-	void StoreVoid()
+	/* Context is about to be resumed, stops counting it as suspended */
+	void Wake(asIScriptContext* Context)
 	{
-		Store(nullptr, asTYPEID_VOID);
+		Await* Target = GetAwait(Context, false);
+		if (Target != nullptr && Target->Suspended)
+		{
+			Target->Suspended = false;
+			Values.Suspended.fetch_sub(1, std::memory_order_relaxed);
+		}
 	}
-	/* Thread safe retrieve function, non-blocking try-retrieve future value */
-	bool Retrieve(void* RefPointer, int RefTypeId)
+	/* Mark that promise awaited by context was settled */
+	void Settle(asIScriptContext* Context)
 	{
-		PROMISE_ASSERT(Engine != nullptr, "promise is malformed (engine is null)");
-		PROMISE_ASSERT(RefPointer != nullptr, "output pointer should not be null");
-		if (Value.TypeId == PROMISE_NULLID)
-			return false;
+		Await* Target = GetAwait(Context, false);
+		if (Target != nullptr && Target->Location != nullptr)
+			Target->SettleTime = AsGetTimestamp();
+	}
+	/* Record latencies when executor resumes context after settle */
+	void Resume(asIScriptContext* Context)
+	{
+		Await* Target = GetAwait(Context, false);
+		if (Target == nullptr || Target->Location == nullptr || !Target->SettleTime)
+			return;
 
-		if (RefTypeId & asTYPEID_OBJHANDLE)
+		uint64_t Time = AsGetTimestamp();
+		Values.SettleToResume.Push(Time > Target->SettleTime ? Time - Target->SettleTime : 0);
+		Target->Location->Suspension.Push(Time > Target->SuspendTime ? Time - Target->SuspendTime : 0);
+		Target->Location = nullptr;
+	}
+	/* Get all counters, safe to read from any thread */
+	Counters& GetCounters()
+	{
+		return Values;
+	}
+	/* Call a function for every known await site */
+	void ForEachSite(const std::function<void(const Site&)>& Callback)
+	{
+		for (auto& Next : Shards)
 		{
-			if ((Value.TypeId & asTYPEID_MASK_OBJECT))
-			{
-				if ((Value.TypeId & asTYPEID_HANDLETOCONST) && !(RefTypeId & asTYPEID_HANDLETOCONST))
-					return false;
-
-				Engine->RefCastObject(Value.Object, Engine->GetTypeInfoById(Value.TypeId), Engine->GetTypeInfoById(RefTypeId), reinterpret_cast<void**>(RefPointer));
-				if (*(asPWORD*)RefPointer == 0)
-					return false;
-
-				return true;
-			}
+			std::unique_lock<std::mutex> Unique(Next.Mutex);
+			for (auto& Item : Next.Sites)
+				Callback(*Item.second);
 		}
-		else if (RefTypeId & asTYPEID_MASK_OBJECT)
+	}
+	/* Export a snapshot of all counters in plain text exposition format (prometheus compatible) */
+	std::string Export()
+	{
+		std::string Result;
+		uint64_t Created = Values.Created.load(std::memory_order_relaxed);
+		uint64_t Destroyed = Values.Destroyed.load(std::memory_order_relaxed);
+		AsExportSample(Result, "promise_created_total", Created);
+		AsExportSample(Result, "promise_live", Created > Destroyed ? Created - Destroyed : 0);
+		AsExportSample(Result, "promise_settled_total", Values.Settled.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_suspended_contexts", Values.Suspended.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_resumed_total", Values.Resumed.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_callbacks_total", Values.Callbacks.load(std::memory_order_relaxed));
+		ExportHistogram(Result, "promise_settle_to_resume_us", Values.SettleToResume);
+		ForEachSite([&Result](const Site& Next)
 		{
-			if (Value.TypeId == RefTypeId)
-			{
-				Engine->AssignScriptObject(RefPointer, Value.Object, Engine->GetTypeInfoById(Value.TypeId));
-				return true;
-			}
+			std::string Labels = "function=\"" + Escape(Next.Function) + "\",section=\"" + Escape(Next.Section) + "\",line=\"" + std::to_string(Next.Line) + "\"";
+			ExportHistogram(Result, "promise_await_suspension_us", Next.Suspension, Labels);
+		});
+		return Result;
+	}
+
+public:
+	static AsPromiseMetrics& Get()
+	{
+		static AsPromiseMetrics Instance;
+		return Instance;
+	}
+	/* Free suspension record of context, registered as context cleanup callback, context destroyed while suspended is no longer counted */
+	static void Cleanup(asIScriptContext* Context)
+	{
+		Await* Target = (Await*)Context->GetUserData(PROMISE_USERID + 10);
+		if (Target != nullptr)
+		{
+			if (Target->Suspended)
+				Get().Values.Suspended.fetch_sub(1, std::memory_order_relaxed);
+			Target->~Await();
+			asFreeMem((void*)Target);
+		}
+	}
+
+private:
+	static Await* GetAwait(asIScriptContext* Context, bool Create)
+	{
+		Await* Target = (Await*)Context->GetUserData(PROMISE_USERID + 10);
+		if (Target != nullptr || !Create)
+			return Target;
+
+		Target = new(asAllocMem(sizeof(Await))) Await();
+		Context->SetUserData((void*)Target, PROMISE_USERID + 10);
+		return Target;
+	}
+	static void ExportHistogram(std::string& Result, const char* Name, const Histogram& Value, const std::string& Labels = std::string())
+	{
+		std::string Prefix = Labels.empty() ? std::string() : Labels + ",";
+		uint64_t Count = 0;
+		for (size_t i = 0; i < PROMISE_METRICS_BUCKETS; i++)
+		{
+			Count += Value.Buckets[i].load(std::memory_order_relaxed);
+			AsExportSample(Result, (std::string(Name) + "_bucket").c_str(), Count, Prefix + "le=\"" + std::to_string((uint64_t)2 << i) + "\"");
+		}
+		AsExportSample(Result, (std::string(Name) + "_bucket").c_str(), Count, Prefix + "le=\"+Inf\"");
+		AsExportSample(Result, (std::string(Name) + "_sum").c_str(), Value.Sum.load(std::memory_order_relaxed), Labels);
+		AsExportSample(Result, (std::string(Name) + "_count").c_str(), Value.Count.load(std::memory_order_relaxed), Labels);
+	}
+	static std::string Escape(const std::string& Value)
+	{
+		std::string Result;
+		for (char V : Value)
+		{
+			if (V == '\\' || V == '\"')
+				Result += '\\';
+			Result += V;
+		}
+		return Result;
+	}
+};
+#define PROMISE_COUNT(Counter) AsPromiseMetrics::Get().GetCounters().Counter.fetch_add(1, std::memory_order_relaxed)
+static void AsMeasureResume(asIScriptContext* Context)
+{
+	AsPromiseMetrics::Get().Resume(Context);
+}
+#else
+#define PROMISE_COUNT(Counter)
+#endif
+#if PROMISE_ADMISSION
+#include <algorithm>
+#include <vector>
+#include <deque>
+/*
+	Admission controller for suspended contexts, each suspended coroutine
+	keeps it's whole context with stack alive until promise settles, this
+	class tracks them and queues or rejects new work when limits are hit,
+	also owns engine context pool so that contexts with large stacks are
+	released instead of being kept idle
+*/
+class AsPromiseAdmission
+{
+public:
+	typedef std::function<size_t(asIScriptContext*)> Estimator;
+	typedef std::function<void(std::function<void()>&&)> Scheduler;
+
+	struct Gauges
+	{
+		size_t Suspended = 0;
+		size_t SuspendedBytes = 0;
+		size_t Running = 0;
+		size_t Queued = 0;
+		size_t Pooled = 0;
+		uint64_t Admitted = 0;
+		uint64_t Rejected = 0;
+		uint64_t Shrunk = 0;
+	};
+
+private:
+	std::mutex Mutex;
+	std::deque<std::function<void()>> Queue;
+	std::vector<asIScriptContext*> Pool;
+	std::atomic<size_t> Suspended;
+	std::atomic<size_t> SuspendedBytes;
+	std::atomic<size_t> Running;
+	std::atomic<uint64_t> Admitted;
+	std::atomic<uint64_t> Rejected;
+	std::atomic<uint64_t> Shrunk;
+	asIScriptEngine* Engine;
+	Estimator Estimate;
+	Scheduler Schedule;
+	size_t MaxSuspended;
+	size_t MaxBytes;
+	size_t MaxQueued;
+	size_t MaxPooled;
+	size_t MaxPooledBytes;
+	bool Draining;
+
+public:
+	/*
+		Zero limit means unlimited, contexts that had estimated stack
+		larger than max pooled bytes are released on return to pool
+	*/
+	AsPromiseAdmission(size_t NewMaxSuspended, size_t NewMaxBytes, size_t NewMaxQueued = 0, size_t NewMaxPooled = 64, size_t NewMaxPooledBytes = 64 * 1024) : Suspended(0), SuspendedBytes(0), Running(0), Admitted(0), Rejected(0), Shrunk(0), Engine(nullptr), MaxSuspended(NewMaxSuspended), MaxBytes(NewMaxBytes), MaxQueued(NewMaxQueued), MaxPooled(NewMaxPooled), MaxPooledBytes(NewMaxPooledBytes), Draining(false)
+	{
+		Estimate = &AsPromiseAdmission::EstimateStack;
+		Schedule = [](std::function<void()>&& Task) { Task(); };
+	}
+	~AsPromiseAdmission()
+	{
+		Detach();
+	}
+	/* Install this controller into engine, also takes over context pool callbacks */
+	void Attach(asIScriptEngine* NewEngine)
+	{
+		PROMISE_ASSERT(NewEngine != nullptr, "script engine should not be null");
+		PROMISE_ASSERT(Engine == nullptr, "admission is already attached to an engine");
+		Engine = NewEngine;
+		Engine->SetUserData(this, PROMISE_USERID + 1);
+		PROMISE_CHECK(Engine->SetContextCallbacks(&AsPromiseAdmission::RequestContext, &AsPromiseAdmission::ReturnContext, this));
+		Engine->SetContextUserDataCleanupCallback(&AsPromiseAdmission::Cleanup, PROMISE_USERID + 11);
+	}
+	/* Remove this controller from engine and release pooled contexts */
+	void Detach()
+	{
+		if (!Engine)
+			return;
+
+		std::unique_lock<std::mutex> Unique(Mutex);
+		for (auto* Context : Pool)
+			Context->Release();
+		Pool.clear();
+		Unique.unlock();
+
+		Engine->SetUserData(nullptr, PROMISE_USERID + 1);
+		PROMISE_CHECK(Engine->SetContextCallbacks(nullptr, nullptr, nullptr));
+		Engine->SetContextUserDataCleanupCallback(nullptr, PROMISE_USERID + 11);
+		Engine = nullptr;
+	}
+	/* Custom stack size estimation of suspended context */
+	void SetEstimator(Estimator&& NewEstimate)
+	{
+		PROMISE_ASSERT(NewEstimate, "estimator should not be empty");
+		Estimate = std::move(NewEstimate);
+	}
+	/*
+		Custom way to run admitted work, default runs in place, work is
+		counted as running until task returns, by then it either finished
+		or suspended, so scheduler should not complete tasks early
+	*/
+	void SetScheduler(Scheduler&& NewSchedule)
+	{
+		PROMISE_ASSERT(NewSchedule, "scheduler should not be empty");
+		Schedule = std::move(NewSchedule);
+	}
+	/*
+		Run new work if suspended contexts are under limits, otherwise
+		queue it until some contexts resume, returns false if work was
+		rejected because queue is also full
+	*/
+	bool Admit(std::function<void()>&& Task)
+	{
+		PROMISE_ASSERT(Task, "task should not be empty");
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Queue.empty() && HasCapacity())
+		{
+			++Running;
+			Unique.unlock();
+			Run(std::move(Task));
+			return true;
+		}
+
+		if (MaxQueued > 0 && Queue.size() >= MaxQueued)
+		{
+			++Rejected;
+			return false;
+		}
+
+		Queue.push_back(std::move(Task));
+		return true;
+	}
+	/*
+		Admit work that caller runs itself, it is counted as running and
+		caller must call <Complete> once it finished or suspended, rejected
+		counter is updated on failure and nothing is queued
+	*/
+	bool TryAdmit()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Queue.empty() && HasCapacity())
+		{
+			++Admitted;
+			++Running;
+			return true;
+		}
+
+		++Rejected;
+		return false;
+	}
+	/* Finish work admitted by <TryAdmit>, queued work may take it's place */
+	void Complete()
+	{
+		PROMISE_ASSERT(Running > 0, "no admitted work is running");
+		--Running;
+		Drain();
+	}
+	/*
+		Called by promise when context gets suspended, estimated bytes
+		are kept in context so that exactly the same amount is released
+	*/
+	void OnSuspend(asIScriptContext* Context)
+	{
+		OnResume(Context);
+		size_t Bytes = Estimate(Context);
+		Context->SetUserData((void*)(uintptr_t)(Bytes + 1), PROMISE_USERID + 11);
+		SuspendedBytes += Bytes;
+		++Suspended;
+		if (MaxPooledBytes > 0 && Bytes > MaxPooledBytes)
+			Context->SetUserData((void*)this, PROMISE_USERID + 2);
+	}
+	/*
+		Called by promise when suspended context is about to be resumed,
+		also called when context is returned to pool or destroyed while
+		suspended, does nothing if context is not counted
+	*/
+	void OnResume(asIScriptContext* Context)
+	{
+		uintptr_t Counted = (uintptr_t)Context->SetUserData(nullptr, PROMISE_USERID + 11);
+		if (!Counted)
+			return;
+
+		SuspendedBytes.fetch_sub((size_t)(Counted - 1));
+		--Suspended;
+	}
+	/*
+		Run queued work while there is capacity, promise calls it after
+		resumed context was handed to executor, only one thread drains
+		at a time, others leave their part to it
+	*/
+	void Drain()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Draining)
+			return;
+
+		Draining = true;
+		while (!Queue.empty() && HasCapacity())
+		{
+			auto Task = std::move(Queue.front());
+			Queue.pop_front();
+			++Running;
+			Unique.unlock();
+			Run(std::move(Task));
+			Unique.lock();
+		}
+		Draining = false;
+	}
+	/* Snapshot of current state */
+	Gauges GetGauges()
+	{
+		Gauges Result;
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Result.Queued = Queue.size();
+		Result.Pooled = Pool.size();
+		Unique.unlock();
+		Result.Suspended = Suspended;
+		Result.SuspendedBytes = SuspendedBytes;
+		Result.Running = Running;
+		Result.Admitted = Admitted;
+		Result.Rejected = Rejected;
+		Result.Shrunk = Shrunk;
+		return Result;
+	}
+
+public:
+	/* Find a controller installed into engine */
+	static AsPromiseAdmission* Get(asIScriptEngine* Engine)
+	{
+		return (AsPromiseAdmission*)Engine->GetUserData(PROMISE_USERID + 1);
+	}
+	/*
+		Default estimation, engine does not expose stack usage so it
+		is approximated by initial stack size plus frame overhead and
+		variable slots of every function on the call stack
+	*/
+	static size_t EstimateStack(asIScriptContext* Context)
+	{
+		size_t Bytes = (size_t)Context->GetEngine()->GetEngineProperty(asEP_INIT_STACK_SIZE);
+		asUINT Frames = Context->GetCallstackSize();
+		for (asUINT i = 0; i < Frames; i++)
+			Bytes += PROMISE_ADMISSION_FRAME_SIZE + (size_t)std::max(0, Context->GetVarCount(i)) * sizeof(asQWORD);
+
+		return Bytes;
+	}
+
+private:
+	void Run(std::function<void()>&& Task)
+	{
+		++Admitted;
+		Schedule([this, Task = std::move(Task)]() mutable
+		{
+			Task();
+			Complete();
+		});
+	}
+	bool HasCapacity()
+	{
+		if (MaxSuspended > 0 && Suspended + Running >= MaxSuspended)
+			return false;
+
+		return !MaxBytes || SuspendedBytes < MaxBytes;
+	}
+	static asIScriptContext* RequestContext(asIScriptEngine* Engine, void* Data)
+	{
+		AsPromiseAdmission* Base = (AsPromiseAdmission*)Data;
+		std::unique_lock<std::mutex> Unique(Base->Mutex);
+		if (Base->Pool.empty())
+		{
+			Unique.unlock();
+			return Engine->CreateContext();
+		}
+
+		asIScriptContext* Context = Base->Pool.back();
+		Base->Pool.pop_back();
+		return Context;
+	}
+	static void ReturnContext(asIScriptEngine*, asIScriptContext* Context, void* Data)
+	{
+		AsPromiseAdmission* Base = (AsPromiseAdmission*)Data;
+		Base->OnResume(Context);
+		bool Oversized = Context->GetUserData(PROMISE_USERID + 2) != nullptr;
+		PROMISE_CHECK(Context->Unprepare());
+
+		std::unique_lock<std::mutex> Unique(Base->Mutex);
+		if (!Oversized && Base->Pool.size() < Base->MaxPooled)
+		{
+			Base->Pool.push_back(Context);
+			return;
+		}
+
+		Unique.unlock();
+		if (Oversized)
+			++Base->Shrunk;
+		Context->Release();
+	}
+	static void Cleanup(asIScriptContext* Context)
+	{
+		AsPromiseAdmission* Base = Get(Context->GetEngine());
+		if (Base != nullptr)
+			Base->OnResume(Context);
+	}
+};
+#endif
+#if PROMISE_REGISTRY
+#include <stdio.h>
+#include <chrono>
+#include <string>
+/*
+	Registry of pending promises, slots live in per-thread shards of chained
+	fixed size chunks, removed slots are pushed to shard's free list without
+	locking, insertion pops from it under a short per-shard flag (so the list
+	is free of ABA), chunks are never freed. Slot ownership is changed only by
+	CAS on slot state. Slot holds references to recorded functions, awaiting
+	context is not referenced (it's stack may hold the promise) and is
+	forgotten when it is destroyed
+*/
+class AsPromiseRegistry
+{
+public:
+	enum : uint32_t
+	{
+		Free = 0,
+		Writing,
+		Active,
+		Inspecting
+	};
+	struct Slot
+	{
+		std::atomic<uint32_t> State;
+		uint32_t Owner;
+		Slot* NextFree;
+		bool Reported;
+		void* Promise;
+		asIScriptContext* Context;
+		asIScriptFunction* CreateFunction;
+		asIScriptFunction* AwaitFunction;
+		int CreateLine;
+		int AwaitLine;
+		uint64_t CreateTime;
+		uint64_t AwaitTime;
+	};
+	struct Snapshot
+	{
+		void* Promise = nullptr;
+		asIScriptContext* Context = nullptr; /* identity only, not referenced */
+		std::string Created;
+		std::string Awaited;
+		std::string Stack;
+		uint64_t Age = 0;
+		uint64_t Suspended = 0;
+	};
+
+private:
+	struct Chunk
+	{
+		Slot Slots[PROMISE_REGISTRY_CHUNK];
+		std::atomic<Chunk*> Next;
+	};
+	struct alignas(64) Shard
+	{
+		Chunk Head;
+		Chunk* Last;
+		std::atomic<Slot*> Released;
+		std::atomic<bool> Popping;
+	};
+
+private:
+	Shard Shards[PROMISE_REGISTRY_SHARDS];
+
+public:
+	AsPromiseRegistry() noexcept
+	{
+		for (uint32_t i = 0; i < PROMISE_REGISTRY_SHARDS; i++)
+		{
+			Shard& Base = Shards[i];
+			Base.Last = &Base.Head;
+			Base.Released = nullptr;
+			Base.Popping = false;
+			Prepare(&Base.Head, i);
+			Release(Base, &Base.Head.Slots[0], &Base.Head.Slots[PROMISE_REGISTRY_CHUNK - 1]);
+		}
+	}
+	~AsPromiseRegistry()
+	{
+		for (auto& Base : Shards)
+		{
+			Chunk* Next = Base.Head.Next.load();
+			while (Next != nullptr)
+			{
+				Chunk* Current = Next;
+				Next = Next->Next.load();
+				Current->~Chunk();
+				asFreeMem((void*)Current);
+			}
+		}
+	}
+	/* Occupy a free slot in calling thread's shard, shard grows by a chunk when none is left */
+	Slot* Insert(void* Promise, asIScriptContext* Context)
+	{
+		uint32_t Index = GetThreadIndex() % PROMISE_REGISTRY_SHARDS;
+		Shard& Base = Shards[Index];
+		while (Base.Popping.exchange(true, std::memory_order_acquire))
+			std::this_thread::yield();
+
+		Slot* Target = Base.Released.load(std::memory_order_acquire);
+		while (Target != nullptr && !Base.Released.compare_exchange_weak(Target, Target->NextFree, std::memory_order_acquire, std::memory_order_acquire))
+			continue;
+
+		if (!Target)
+		{
+			Chunk* Created = new(asAllocMem(sizeof(Chunk))) Chunk();
+			Prepare(Created, Index);
+			Release(Base, &Created->Slots[1], &Created->Slots[PROMISE_REGISTRY_CHUNK - 1]);
+			Base.Last->Next.store(Created, std::memory_order_release);
+			Base.Last = Created;
+			Target = &Created->Slots[0];
+		}
+		Base.Popping.store(false, std::memory_order_release);
+
+		Target->State.store(Writing, std::memory_order_relaxed);
+		Target->Reported = false;
+		Target->Promise = Promise;
+		Target->Context = nullptr;
+		Target->CreateFunction = Context != nullptr ? Context->GetFunction(0) : nullptr;
+		Target->CreateLine = Context != nullptr ? Context->GetLineNumber(0) : 0;
+		if (Target->CreateFunction != nullptr)
+			Target->CreateFunction->AddRef();
+		Target->AwaitFunction = nullptr;
+		Target->AwaitLine = 0;
+		Target->CreateTime = AsGetTimestamp();
+		Target->AwaitTime = 0;
+		Target->State.store(Active, std::memory_order_release);
+		return Target;
+	}
+	/* Remember where and when promise was awaited, ignored if slot was already given to other promise */
+	void Await(Slot* Target, void* Promise, asIScriptContext* Context)
+	{
+		if (!Acquire(Target, Writing))
+			return;
+
+		if (Target->Promise != Promise)
+		{
+			Target->State.store(Active, std::memory_order_release);
+			return;
+		}
+
+		asIScriptFunction* Previous = Target->AwaitFunction;
+		Target->Context = Context;
+		Target->AwaitFunction = Context->GetFunction(0);
+		Target->AwaitLine = Context->GetLineNumber(0);
+		Target->AwaitTime = AsGetTimestamp();
+		if (Target->AwaitFunction != nullptr)
+			Target->AwaitFunction->AddRef();
+		Context->SetUserData(Target, PROMISE_USERID + 12);
+		Target->State.store(Active, std::memory_order_release);
+		if (Previous != nullptr)
+			Previous->Release();
+	}
+	/* Free slot, waits for inspection of this slot to finish */
+	void Remove(Slot* Target)
+	{
+		if (!Acquire(Target, Writing))
+			return;
+
+		asIScriptFunction* CreateFunction = Target->CreateFunction;
+		asIScriptFunction* AwaitFunction = Target->AwaitFunction;
+		Target->Context = nullptr;
+		Target->CreateFunction = nullptr;
+		Target->AwaitFunction = nullptr;
+		Target->State.store(Free, std::memory_order_release);
+		Release(Shards[Target->Owner], Target, Target);
+		if (CreateFunction != nullptr)
+			CreateFunction->Release();
+		if (AwaitFunction != nullptr)
+			AwaitFunction->Release();
+	}
+	/* Context cleanup callback, forgets destroyed context after inspection of it's slot finished */
+	static void Cleanup(asIScriptContext* Context)
+	{
+		Slot* Target = (Slot*)Context->GetUserData(PROMISE_USERID + 12);
+		AsPromiseRegistry& Base = Get();
+		if (!Base.Acquire(Target, Writing))
+			return;
+
+		if (Target->Context == Context)
+			Target->Context = nullptr;
+		Target->State.store(Active, std::memory_order_release);
+	}
+	/*
+		Call back for every pending promise older than age (microseconds), callback runs
+		after slot was released, stacks are captured for contexts suspended on a promise
+	*/
+	size_t Enumerate(const std::function<void(const Snapshot&)>& Callback, uint64_t MinAge = 0, bool OnlyUnreported = false, bool WithStacks = true)
+	{
+		size_t Count = 0;
+		uint64_t Time = AsGetTimestamp();
+		for (auto& Base : Shards)
+		{
+			for (Chunk* Current = &Base.Head; Current != nullptr; Current = Current->Next.load(std::memory_order_acquire))
+			{
+				for (auto& Target : Current->Slots)
+				{
+					uint32_t Expected = Active;
+					if (Target.State.load(std::memory_order_relaxed) != Active || !Target.State.compare_exchange_strong(Expected, Inspecting, std::memory_order_acquire, std::memory_order_relaxed))
+						continue;
+
+					uint64_t Age = Time > Target.CreateTime ? Time - Target.CreateTime : 0;
+					if (Age < MinAge || (OnlyUnreported && Target.Reported))
+					{
+						Target.State.store(Active, std::memory_order_release);
+						continue;
+					}
+
+					Snapshot Next;
+					Next.Promise = Target.Promise;
+					Next.Context = Target.Context;
+					Next.Age = Age;
+					Next.Suspended = Target.AwaitTime > 0 && Time > Target.AwaitTime ? Time - Target.AwaitTime : 0;
+					Next.Created = GetLocation(Target.CreateFunction, Target.CreateLine);
+					Next.Awaited = GetLocation(Target.AwaitFunction, Target.AwaitLine);
+					if (WithStacks && Target.Context != nullptr && Target.Context->GetState() == asEXECUTION_SUSPENDED && Target.Context->GetUserData(PROMISE_USERID) == Target.Promise)
+						Next.Stack = GetStack(Target.Context);
+					Target.Reported = true;
+					Target.State.store(Active, std::memory_order_release);
+
+					Callback(Next);
+					++Count;
+				}
+			}
+		}
+		return Count;
+	}
+	/* Human readable list of pending promises */
+	std::string Dump(uint64_t MinAge = 0)
+	{
+		std::string Result;
+		Enumerate([&Result](const Snapshot& Next) { Result += Format(Next); }, MinAge);
+		return Result;
+	}
+
+private:
+	/* Link free slots of chunk in order, chunk is not yet visible to other threads */
+	static void Prepare(Chunk* Target, uint32_t Owner)
+	{
+		for (uint32_t i = 0; i < PROMISE_REGISTRY_CHUNK; i++)
+		{
+			Slot& Next = Target->Slots[i];
+			Next.State = Free;
+			Next.Owner = Owner;
+			Next.NextFree = i + 1 < PROMISE_REGISTRY_CHUNK ? &Target->Slots[i + 1] : nullptr;
+		}
+		Target->Next = nullptr;
+	}
+	/* Push linked run of free slots to shard's free list, safe from any thread */
+	static void Release(Shard& Base, Slot* First, Slot* Last)
+	{
+		Slot* Head = Base.Released.load(std::memory_order_relaxed);
+		do
+		{
+			Last->NextFree = Head;
+		} while (!Base.Released.compare_exchange_weak(Head, First, std::memory_order_release, std::memory_order_relaxed));
+	}
+	bool Acquire(Slot* Target, uint32_t Status)
+	{
+		if (!Target)
+			return false;
+
+		uint32_t Expected = Active;
+		while (!Target->State.compare_exchange_weak(Expected, Status, std::memory_order_acquire, std::memory_order_relaxed))
+		{
+			if (Expected != Inspecting && Expected != Active)
+				return false;
+
+			Expected = Active;
+			std::this_thread::yield();
+		}
+		return true;
+	}
+
+public:
+	static std::string Format(const Snapshot& Next)
+	{
+		char Address[32];
+		snprintf(Address, sizeof(Address), "%p", Next.Promise);
+		std::string Result = "promise ";
+		Result += Address;
+		Result += " pending for " + std::to_string(Next.Age / 1000) + " ms (suspended for " + std::to_string(Next.Suspended / 1000) + " ms)\n";
+		Result += "  created at " + Next.Created + "\n";
+		Result += "  awaited at " + Next.Awaited + "\n";
+		return Result + Next.Stack;
+	}
+	static std::string GetLocation(asIScriptFunction* Function, int Line)
+	{
+		if (!Function)
+			return "<none>";
+
+		const char* Section = Function->GetScriptSectionName();
+		return std::string(Function->GetDeclaration()) + " (" + (Section ? Section : "?") + ":" + std::to_string(Line) + ")";
+	}
+	static std::string GetStack(asIScriptContext* Context)
+	{
+		std::string Result;
+		asUINT Size = Context->GetCallstackSize();
+		for (asUINT i = 0; i < Size; i++)
+		{
+			asIScriptFunction* Function = Context->GetFunction(i);
+			if (Function != nullptr)
+				Result += "    #" + std::to_string(i) + " " + GetLocation(Function, Context->GetLineNumber(i)) + "\n";
+		}
+		return Result;
+	}
+	static uint32_t GetThreadIndex()
+	{
+		static std::atomic<uint32_t> Counter(0);
+		static thread_local uint32_t Index = Counter++;
+		return Index;
+	}
+	static AsPromiseRegistry& Get()
+	{
+		static AsPromiseRegistry Base;
+		return Base;
+	}
+};
+
+/* Thread that periodically reports promises pending longer than threshold, each promise once */
+class AsPromiseWatchdog
+{
+public:
+	typedef std::function<void(const AsPromiseRegistry::Snapshot&)> ReportCallback;
+
+private:
+	ReportCallback Callback;
+	std::condition_variable Notify;
+	std::mutex Mutex;
+	std::thread Thread;
+	uint64_t Threshold;
+	uint64_t Interval;
+	bool Active;
+
+public:
+	AsPromiseWatchdog(uint64_t ThresholdMs, uint64_t IntervalMs = 1000, ReportCallback&& NewCallback = &AsPromiseWatchdog::Print) : Callback(std::move(NewCallback)), Threshold(ThresholdMs * 1000), Interval(IntervalMs), Active(true)
+	{
+		PROMISE_ASSERT(Callback, "report callback should not be empty");
+		Thread = std::thread(&AsPromiseWatchdog::Loop, this);
+	}
+	AsPromiseWatchdog(const AsPromiseWatchdog&) = delete;
+	AsPromiseWatchdog& operator= (const AsPromiseWatchdog&) = delete;
+	~AsPromiseWatchdog()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Active = false;
+		Unique.unlock();
+		Notify.notify_all();
+		Thread.join();
+	}
+	/* Default report, written to stderr */
+	static void Print(const AsPromiseRegistry::Snapshot& Next)
+	{
+		fprintf(stderr, "[stalled] %s", AsPromiseRegistry::Format(Next).c_str());
+	}
+
+private:
+	void Loop()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		while (Active)
+		{
+			Notify.wait_for(Unique, std::chrono::milliseconds(Interval));
+			if (!Active)
+				break;
+
+			Unique.unlock();
+			AsPromiseRegistry::Get().Enumerate(Callback, Threshold, true);
+			Unique.lock();
+		}
+	}
+};
+#endif
+
+/*
+	Tag that new promise inherits from it's context, stored in the
+	promise for executors that dispatch per promise, zero by default
+*/
+template <typename Executor>
+struct AsExecutorTag
+{
+	static uint8_t Get(asIScriptContext*)
+	{
+		return 0;
+	}
+};
+
+/*
+	Packed promise state, reference count, garbage collector mark,
+	spin lock and settlement status share one atomic word, promise
+	critical sections are tiny so spinning is cheaper than a mutex
+*/
+class AsPromiseState
+{
+public:
+	enum : uint32_t
+	{
+		Marked = 1 << 0,
+		Locked = 1 << 1,
+		Fulfilled = 1 << 2,
+		Rejected = 1 << 3,
+		Lazy = 1 << 4,
+		Settled = Fulfilled | Rejected,
+		Reference = 1 << 8
+	};
+
+private:
+	std::atomic<uint32_t> Word;
+
+public:
+	AsPromiseState() noexcept : Word(Reference)
+	{
+	}
+	/* Add reference, garbage collector mark is cleared, returns new reference count */
+	uint32_t AddRef()
+	{
+		Unmark();
+		return Word.fetch_add(Reference, std::memory_order_relaxed) / Reference + 1;
+	}
+	/* Remove reference, garbage collector mark is cleared, returns new reference count */
+	uint32_t Release()
+	{
+		Unmark();
+		return Word.fetch_sub(Reference, std::memory_order_acq_rel) / Reference - 1;
+	}
+	uint32_t GetRefCount() const
+	{
+		return Word.load(std::memory_order_relaxed) / Reference;
+	}
+	void Mark()
+	{
+		Word.fetch_or(Marked, std::memory_order_relaxed);
+	}
+	bool IsMarked() const
+	{
+		return (Word.load(std::memory_order_relaxed) & Marked) != 0;
+	}
+	/* Publish status flags, value written before is visible to readers of flags */
+	void Set(uint32_t Flags)
+	{
+		Word.fetch_or(Flags, std::memory_order_release);
+	}
+	bool Has(uint32_t Flags) const
+	{
+		return (Word.load(std::memory_order_acquire) & Flags) != 0;
+	}
+	void Clear(uint32_t Flags)
+	{
+		Word.fetch_and(~Flags, std::memory_order_relaxed);
+	}
+	void lock()
+	{
+		uint32_t Spins = 0;
+		uint32_t Current = Word.load(std::memory_order_relaxed);
+		while (true)
+		{
+			if (!(Current & Locked) && Word.compare_exchange_weak(Current, Current | Locked, std::memory_order_acquire, std::memory_order_relaxed))
+				return;
+
+			if (++Spins > 64)
+				std::this_thread::yield();
+			Current = Word.load(std::memory_order_relaxed);
+		}
+	}
+	void unlock()
+	{
+		Word.fetch_and(~(uint32_t)Locked, std::memory_order_release);
+	}
+
+private:
+	void Unmark()
+	{
+		if (Word.load(std::memory_order_relaxed) & Marked)
+			Word.fetch_and(~(uint32_t)Marked, std::memory_order_relaxed);
+	}
+};
+
+/*
+	Basic promise class that can be used for non-blocking asynchronous operation
+	data exchange between AngelScript and C++ and vice-versa.
+*/
+template <typename Executor>
+class AsBasicPromise
+{
+private:
+	/* Basically used from <any> class */
+	struct Dynamic
+	{
+		union
+		{
+			asINT64 Integer;
+			double Number;
+			void* Object;
+		};
+
+		int TypeId = PROMISE_NULLID;
+	};
+	/* Rarely used fields, allocated on demand to keep promise within a cache line */
+	struct Extension
+	{
+#if PROMISE_CALLBACKS
+		std::function<void(AsBasicPromise<Executor>*)> Native;
+		asIScriptFunction* Wrapper = nullptr;
+#endif
+		std::vector<std::function<void(AsBasicPromise<Executor>*)>> Continuations;
+		std::function<void(AsBasicPromise<Executor>*)> Producer;
+		int ErrorCode = 0;
+	};
+
+private:
+	asIScriptEngine* Engine;
+	asIScriptContext* Context;
+	Extension* Rare;
+	Dynamic Value;
+	AsPromiseState State;
+	uint8_t Tag;
+#if PROMISE_REGISTRY
+	AsPromiseRegistry::Slot* Entry;
+#endif
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		PROMISE_ASSERT(State.GetRefCount() > 0, "promise is already released");
+		if (!State.Release())
+		{
+			ReleaseReferences(nullptr);
+			PROMISE_COUNT(Destroyed);
+			this->~AsBasicPromise();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		PROMISE_ASSERT(State.GetRefCount() < std::numeric_limits<uint32_t>::max() / AsPromiseState::Reference, "too many references to this promise");
+		State.AddRef();
+	}
+	/* For garbage collector to detect references */
+	void EnumReferences(asIScriptEngine* OtherEngine)
+	{
+		if (Value.Object != nullptr && (Value.TypeId & asTYPEID_MASK_OBJECT))
+		{
+			asITypeInfo* SubType = Engine->GetTypeInfoById(Value.TypeId);
+			if ((SubType->GetFlags() & asOBJ_REF))
+				OtherEngine->GCEnumCallback(Value.Object);
+			else if ((SubType->GetFlags() & asOBJ_VALUE) && (SubType->GetFlags() & asOBJ_GC))
+				Engine->ForwardGCEnumReferences(Value.Object, SubType);
+
+			asITypeInfo* Type = OtherEngine->GetTypeInfoById(Value.TypeId);
+			if (Type != nullptr)
+				OtherEngine->GCEnumCallback(Type);
+		}
+#if PROMISE_CALLBACKS
+		if (Rare != nullptr && Rare->Wrapper != nullptr)
+		{
+			void* DelegateObject = Rare->Wrapper->GetDelegateObject();
+			if (DelegateObject != nullptr)
+				OtherEngine->GCEnumCallback(DelegateObject);
+			OtherEngine->GCEnumCallback(Rare->Wrapper);
+		}
+#endif
+	}
+	/* For garbage collector to release references */
+	void ReleaseReferences(asIScriptEngine*)
+	{
+		if (Value.TypeId & asTYPEID_MASK_OBJECT)
+		{
+			asITypeInfo* Type = Engine->GetTypeInfoById(Value.TypeId);
+			Engine->ReleaseScriptObject(Value.Object, Type);
+			if (Type != nullptr)
+				Type->Release();
+			Clean();
+		}
+#if PROMISE_CALLBACKS
+		if (Rare != nullptr && Rare->Wrapper != nullptr)
+		{
+			AsClearCallback(Rare->Wrapper);
+			Rare->Wrapper = nullptr;
+		}
+#endif
+	}
+	/* For garbage collector to mark */
+	void MarkRef()
+	{
+		State.Mark();
+	}
+	/* For garbage collector to check mark */
+	bool IsRefMarked()
+	{
+		return State.IsMarked();
+	}
+	/* For garbage collector to check reference count */
+	uint32_t GetRefCount()
+	{
+		return State.GetRefCount();
+	}
+	/* Receive stored type id of future value */
+	int GetTypeIdOfObject()
+	{
+		return Value.TypeId;
+	}
+	/* Provide a native callback that should be fired when promise will be settled */
+	void When(std::function<void(AsBasicPromise<Executor>*)>&& NewCallback)
+	{
+#if PROMISE_CALLBACKS
+		Start();
+		std::unique_lock<AsPromiseState> Unique(State);
+		Extension* Base = GetExtension();
+		Base->Native = std::move(NewCallback);
+		if (Base->Native && !IsPending())
+		{
+			auto Callback = std::move(Base->Native);
+			Unique.unlock();
+			PROMISE_TRACE(Callback, this, Context);
+			PROMISE_COUNT(Callbacks);
+			Callback(this);
+		}
+#else
+		PROMISE_ASSERT(false, "native callback binder for <when> is not allowed");
+#endif
+	}
+	/* Provide a script callback that should be fired when promise will be settled */
+	void When(asIScriptFunction* NewCallback)
+	{
+#if PROMISE_CALLBACKS
+		Start();
+		if (NewCallback != nullptr)
+		{
+			void* DelegateObject = NewCallback->GetDelegateObject();
+			if (DelegateObject != nullptr)
+				Context->GetEngine()->AddRefScriptObject(DelegateObject, NewCallback->GetDelegateObjectType());
+		}
+
+		std::unique_lock<AsPromiseState> Unique(State);
+		Extension* Base = GetExtension();
+		asIScriptFunction* OldCallback = Base->Wrapper;
+		Base->Wrapper = NewCallback;
+		bool Settled = NewCallback != nullptr && !IsPending();
+		if (Settled)
+			Base->Wrapper = nullptr;
+		Unique.unlock();
+
+		if (OldCallback != nullptr)
+			AsClearCallback(OldCallback);
+
+		if (Settled)
+		{
+			PROMISE_TRACE(Callback, this, Context);
+			PROMISE_COUNT(Callbacks);
+			Executor()(this, Context, NewCallback);
+		}
+#else
+		PROMISE_ASSERT(false, "script callback binder for <when> is not allowed");
+#endif
+	}
+	/*
+		Add a continuation that runs inline on the thread that settles the promise
+		(or in place if it is already settled), no context is suspended or resumed
+	*/
+	void Attach(std::function<void(AsBasicPromise<Executor>*)>&& Continuation)
+	{
+		PROMISE_ASSERT(Continuation, "continuation should not be empty");
+		Start();
+		std::unique_lock<AsPromiseState> Unique(State);
+		if (IsPending())
+		{
+			GetExtension()->Continuations.push_back(std::move(Continuation));
+			return;
+		}
+
+		Unique.unlock();
+		Continuation(this);
+	}
+	/*
+		Derive a promise that is settled by continuation, continuation runs inline
+		and should settle target promise, rejection of this promise is propagated
+		to target without calling continuation, chains of derived promises are
+		settled within one dispatch by the thread that settles the first one
+	*/
+	AsBasicPromise* Then(std::function<void(AsBasicPromise<Executor>*, AsBasicPromise<Executor>*)>&& Continuation)
+	{
+		PROMISE_ASSERT(Continuation, "continuation should not be empty");
+		asIScriptContext* ThisContext = asGetActiveContext();
+		AsBasicPromise* Target = Create(ThisContext ? ThisContext : Context);
+		Start();
+		std::unique_lock<AsPromiseState> Unique(State);
+		if (!IsPending())
+		{
+			Unique.unlock();
+			Derive(Target, Continuation);
+			return Target;
+		}
+
+		/* Continuation takes it's own reference only if it has to outlive this call */
+		Target->AddRef();
+		GetExtension()->Continuations.push_back([Target, Continuation = std::move(Continuation)](AsBasicPromise<Executor>* Source)
+		{
+			Source->Derive(Target, Continuation);
+			Target->Release();
+		});
+		return Target;
+	}
+	/* Script <map> implementation, transform runs inline when promise settles */
+	AsBasicPromise* MapInline(asIScriptFunction* Callback)
+	{
+		PROMISE_ASSERT(Callback != nullptr, "callback should not be null");
+		std::shared_ptr<asIScriptFunction> Transform = Retain(Callback);
+		return Then([Transform](AsBasicPromise<Executor>* Source, AsBasicPromise<Executor>* Target)
+		{
+			ExecuteInline(Transform.get(), [Source](asIScriptContext* Inline)
+			{
+				return Inline->SetArgAddress(0, GetAddressOf(Source->Value));
+			}, [&Transform, Target](asIScriptContext* Inline, int Status)
+			{
+				if (Status == asEXECUTION_FINISHED)
+					Target->Store(Inline->GetAddressOfReturnValue(), Transform->GetReturnTypeId());
+				else
+					Target->Reject(PROMISE_CONTINUATION_ERROR);
+			});
+		});
+	}
+	/* Script <then> implementation, callback runs inline when promise settles */
+	AsBasicPromise* ThenInline(asIScriptFunction* Callback)
+	{
+		PROMISE_ASSERT(Callback != nullptr, "callback should not be null");
+		std::shared_ptr<asIScriptFunction> Continuation = Retain(Callback);
+		return Then([Continuation](AsBasicPromise<Executor>* Source, AsBasicPromise<Executor>* Target)
+		{
+			ExecuteInline(Continuation.get(), [Source](asIScriptContext* Inline)
+			{
+				return Inline->SetArgObject(0, Source);
+			}, [Target](asIScriptContext*, int Status)
+			{
+				if (Status == asEXECUTION_FINISHED)
+					Target->StoreVoid();
+				else
+					Target->Reject(PROMISE_CONTINUATION_ERROR);
+			});
+		});
+	}
+	/* Settle target promise by continuation or propagate rejection of this promise */
+	void Derive(AsBasicPromise* Target, const std::function<void(AsBasicPromise<Executor>*, AsBasicPromise<Executor>*)>& Continuation)
+	{
+		if (IsFailed())
+			Propagate(Target);
+		else
+			Continuation(this, Target);
+	}
+	/* Settle target promise with same value or error as this one */
+	void Propagate(AsBasicPromise* Target)
+	{
+		PROMISE_ASSERT(Target != nullptr, "target promise should not be null");
+		PROMISE_ASSERT(!IsPending(), "promise should be settled before propagation");
+		if (IsFailed())
+			Target->Reject(GetErrorCode(), GetAddressOf(Value), Value.TypeId);
+		else
+			Target->Store(GetAddressOf(Value), Value.TypeId);
+	}
+	/*
+		Thread safe store function, this is used as promise resolver function,
+		will either only store the result or store result and execute callback
+		that will resume suspended context and then release the promise (won't destroy)
+	*/
+	void Store(void* RefPointer, int RefTypeId)
+	{
+		std::unique_lock<AsPromiseState> Unique(State);
+		PROMISE_ASSERT(RefPointer != nullptr || RefTypeId == asTYPEID_VOID, "input pointer should not be null");
+		if (!IsSettleable())
+			return;
+
+		Assign(Value, RefPointer, RefTypeId);
+		Settle(Unique, AsPromiseState::Fulfilled);
+	}
+	/* Thread safe store function, a little easier for C++ usage */
+	void Store(void* RefPointer, const char* TypeName)
+	{
+		PROMISE_ASSERT(Engine != nullptr, "promise is malformed (engine is null)");
+		PROMISE_ASSERT(TypeName != nullptr, "typename should not be null");
+		Store(RefPointer, Engine->GetTypeIdByDecl(TypeName));
+	}
+	/* Thread safe store function, for promise<void> */
+	void StoreVoid()
+	{
+		Store(nullptr, asTYPEID_VOID);
+	}
+	/*
+		Thread safe reject function, settles the promise into failed state
+		with error code and optional detail object, unlike exceptions this
+		does not unwind the context and does not allocate any strings
+	*/
+	void Reject(int Code, void* RefPointer = nullptr, int RefTypeId = asTYPEID_VOID)
+	{
+		std::unique_lock<AsPromiseState> Unique(State);
+		PROMISE_ASSERT(RefPointer != nullptr || RefTypeId == asTYPEID_VOID, "input pointer should not be null");
+		if (!IsSettleable())
+			return;
+
+		Assign(Value, RefPointer, RefTypeId);
+		GetExtension()->ErrorCode = Code;
+		Settle(Unique, AsPromiseState::Rejected);
+	}
+	/* Thread safe reject function, for script usage without detail object */
+	void RejectCode(int Code)
+	{
+		Reject(Code);
+	}
+	/* Thread safe retrieve function, non-blocking try-retrieve future value */
+	bool Retrieve(void* RefPointer, int RefTypeId)
+	{
+		PROMISE_ASSERT(Engine != nullptr, "promise is malformed (engine is null)");
+		PROMISE_ASSERT(RefPointer != nullptr, "output pointer should not be null");
+		if (IsFailed())
+			return false;
+
+		return Extract(Value, RefPointer, RefTypeId);
+	}
+	/* Thread safe retrieve function for detail object of rejected promise */
+	bool RetrieveError(void* RefPointer, int RefTypeId)
+	{
+		PROMISE_ASSERT(Engine != nullptr, "promise is malformed (engine is null)");
+		PROMISE_ASSERT(RefPointer != nullptr, "output pointer should not be null");
+		if (!IsFailed())
+			return false;
+
+		return Extract(Value, RefPointer, RefTypeId);
+	}
+	/* Thread safe retrieve function, also non-blocking, another syntax is used */
+	void* Retrieve()
+	{
+		RetrieveVoid();
+		if (IsPending() || IsFailed())
+			return nullptr;
+
+		return GetAddressOf(Value);
+	}
+	/* Thread safe retrieve function */
+	void RetrieveVoid()
+	{
+		std::unique_lock<AsPromiseState> Unique(State);
+		asIScriptContext* ThisContext = asGetActiveContext();
+		if (ThisContext != nullptr && IsPending())
+			ThisContext->SetException("promise is still pending");
+		else if (ThisContext != nullptr && IsFailed())
+			ThisContext->SetException("promise is rejected");
+	}
+	/* Check if promise was settled through reject */
+	bool IsFailed()
+	{
+		return State.Has(AsPromiseState::Rejected);
+	}
+	/* Error code of rejected promise, zero otherwise */
+	int GetErrorCode()
+	{
+		return IsFailed() ? Rare->ErrorCode : 0;
+	}
+	/* Can be used to check if promise is still pending */
+	bool IsPending()
+	{
+		return !State.Has(AsPromiseState::Settled);
+	}
+	/* Pending check for scripts, starts producer of lazy promise */
+	bool Poll()
+	{
+		Start();
+		return IsPending();
+	}
+	/*
+		Run producer of lazy promise once, called by first <yield>, <when>,
+		<pending> or wait, producer of a promise that is released or settled
+		before that is never called
+	*/
+	void Start()
+	{
+		if (!State.Has(AsPromiseState::Lazy))
+			return;
+
+		std::unique_lock<AsPromiseState> Unique(State);
+		if (!State.Has(AsPromiseState::Lazy))
+			return;
+
+		State.Clear(AsPromiseState::Lazy);
+		auto Producer = std::move(Rare->Producer);
+		Unique.unlock();
+		Producer(this);
+	}
+	/* Executor tag of this promise, polymorphic executor resumes through policy of this tag */
+	uint8_t GetExecutorTag() const
+	{
+		return Tag;
+	}
+	/* Override executor tag, must be done before promise is settled */
+	void SetExecutorTag(uint8_t NewTag)
+	{
+		Tag = NewTag;
+	}
+	/* Context that is resumed when promise settles, last awaiting one */
+	asIScriptContext* GetContext()
+	{
+		std::unique_lock<AsPromiseState> Unique(State);
+		return Context;
+	}
+	/*
+		This function should be called before retrieving the value
+		from promise, it will either suspend current context and add
+		reference to this promise if it is still pending or do nothing
+		if promise was already settled
+	*/
+	AsBasicPromise* YieldIf()
+	{
+		Start();
+		std::unique_lock<AsPromiseState> Unique(State);
+		/*
+			Pending promise is bound to the context that awaits it, it may be created
+			by one context and awaited by another (e.g. passed to spawned function),
+			settling then resumes the awaiting context instead of the creating one
+		*/
+		asIScriptContext* ThisContext = asGetActiveContext();
+		if (IsPending() && ThisContext != nullptr)
+			Context = ThisContext;
+
+		if (!IsPending() || Context == nullptr || Context->Suspend() < 0)
+			return this;
+
+		PROMISE_TRACE(Suspend, this, Context);
+		Context->SetUserData(this, PROMISE_USERID);
+		asIScriptContext* Suspending = Context;
+#if PROMISE_REGISTRY
+		AsPromiseRegistry::Slot* Awaited = Entry;
+#endif
+		Unique.unlock();
+
+		/*
+			Bookkeeping runs unlocked, context is resumed only after it
+			leaves this call so settling thread cannot get ahead of it
+		*/
+#if PROMISE_METRICS
+		AsPromiseMetrics::Get().Suspend(Suspending);
+#endif
+#if PROMISE_ADMISSION
+		AsPromiseAdmission* Admission = AsPromiseAdmission::Get(Engine);
+		if (Admission != nullptr)
+			Admission->OnSuspend(Suspending);
+#endif
+#if PROMISE_REGISTRY
+		AsPromiseRegistry::Get().Await(Awaited, this, Suspending);
+#endif
+		return this;
+	}
+	/*
+		This function can be used to await for promise
+		within C++ code (blocking style)
+	*/
+	AsBasicPromise* WaitIf()
+	{
+		Start();
+		if (!IsPending())
+			return this;
+
+		std::mutex Mutex;
+		std::condition_variable Ready;
+		bool Done = false;
+		Attach([&Mutex, &Ready, &Done](AsBasicPromise<Executor>*)
+		{
+			std::unique_lock<std::mutex> Unique(Mutex);
+			Done = true;
+			Ready.notify_all();
+		});
+
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Ready.wait(Unique, [&Done]() { return Done; });
+		return this;
+	}
+
+private:
+	/*
+		Construct a promise, notify GC, set value to none,
+		grab a reference to script context
+	*/
+	AsBasicPromise(asIScriptContext* NewContext) noexcept : Engine(nullptr), Context(NewContext), Rare(nullptr), Tag(0)
+	{
+		static_assert(sizeof(AsBasicPromise) <= 64, "promise should fit into a cache line");
+		PROMISE_ASSERT(Context != nullptr, "context should not be null");
+		Engine = Context->GetEngine();
+		Tag = AsExecutorTag<Executor>::Get(Context);
+		Engine->NotifyGarbageCollectorOfNewObject(this, Engine->GetTypeInfoByName(PROMISE_TYPENAME));
+		Clean();
+		PROMISE_TRACE(Create, this, Context);
+		PROMISE_COUNT(Created);
+#if PROMISE_REGISTRY
+		Entry = AsPromiseRegistry::Get().Insert(this, Context);
+#endif
+	}
+	/* Free rarely used fields */
+	~AsBasicPromise()
+	{
+#if PROMISE_REGISTRY
+		if (Entry != nullptr)
+			AsPromiseRegistry::Get().Remove(Entry);
+#endif
+		if (Rare != nullptr)
+		{
+			Rare->~Extension();
+			asFreeMem((void*)Rare);
+		}
+	}
+	/* Allocate rarely used fields on first use, must be called under lock */
+	Extension* GetExtension()
+	{
+		if (!Rare)
+			Rare = new(asAllocMem(sizeof(Extension))) Extension();
+
+		return Rare;
+	}
+	/* Check if promise can be settled, must be called under lock */
+	bool IsSettleable()
+	{
+		PROMISE_ASSERT(IsPending(), "promise should be settled only once");
+		PROMISE_ASSERT(Engine != nullptr, "promise is malformed (engine is null)");
+		PROMISE_ASSERT(Context != nullptr, "promise is malformed (context is null)");
+		if (IsPending())
+			return true;
+
+		asIScriptContext* ThisContext = asGetActiveContext();
+		if (!ThisContext)
+			ThisContext = Context;
+		ThisContext->SetException("promise is already fulfilled");
+		return false;
+	}
+	/*
+		Notify listeners and resume suspended context after
+		value or error was assigned, lock will be released
+	*/
+	void Settle(std::unique_lock<AsPromiseState>& Unique, uint32_t Status)
+	{
+		State.Clear(AsPromiseState::Lazy);
+		State.Set(Status);
+		PROMISE_TRACE(Store, this, Context);
+		PROMISE_COUNT(Settled);
+#if PROMISE_REGISTRY
+		AsPromiseRegistry::Get().Remove(Entry);
+		Entry = nullptr;
+#endif
+		bool SuspendOwned = Context->GetUserData(PROMISE_USERID) == (void*)this;
+		if (SuspendOwned)
+			Context->SetUserData(nullptr, PROMISE_USERID);
+
+		bool WantsResume = (Context->GetState() == asEXECUTION_SUSPENDED && SuspendOwned);
+#if PROMISE_METRICS
+		if (WantsResume)
+			AsPromiseMetrics::Get().Settle(Context);
+#endif
+		std::vector<std::function<void(AsBasicPromise<Executor>*)>> Chain;
+#if PROMISE_CALLBACKS
+		std::function<void(AsBasicPromise<Executor>*)> NativeCallback;
+		asIScriptFunction* WrapperCallback = nullptr;
+		if (Rare != nullptr)
+		{
+			Chain = std::move(Rare->Continuations);
+			NativeCallback = std::move(Rare->Native);
+			WrapperCallback = Rare->Wrapper;
+			Rare->Wrapper = nullptr;
+		}
+		Unique.unlock();
+		for (auto& Continuation : Chain)
+			Continuation(this);
+
+		if (NativeCallback != nullptr)
+		{
+			PROMISE_TRACE(Callback, this, Context);
+			PROMISE_COUNT(Callbacks);
+			NativeCallback(this);
+		}
+		
+		if (WrapperCallback != nullptr)
+		{
+			PROMISE_TRACE(Callback, this, Context);
+			PROMISE_COUNT(Callbacks);
+			Executor()(this, Context, WrapperCallback);
+		}
+#else
+		if (Rare != nullptr)
+			Chain = std::move(Rare->Continuations);
+		Unique.unlock();
+		for (auto& Continuation : Chain)
+			Continuation(this);
+#endif
+		if (WantsResume)
+		{
+			PROMISE_TRACE(Resume, this, Context);
+#if PROMISE_METRICS
+			AsPromiseMetrics::Get().Wake(Context);
+			PROMISE_COUNT(Resumed);
+#endif
+#if PROMISE_ADMISSION
+			AsPromiseAdmission* Admission = AsPromiseAdmission::Get(Engine);
+			if (Admission != nullptr)
+				Admission->OnResume(Context);
+			Executor()(this, Context);
+			if (Admission != nullptr)
+				Admission->Drain();
+#else
+			Executor()(this, Context);
+#endif
+		}
+	}
+	/* Copy or reference input value into storage */
+	void Assign(Dynamic& Target, void* RefPointer, int RefTypeId)
+	{
+		if ((RefTypeId & asTYPEID_MASK_OBJECT))
+		{
+			asITypeInfo* Type = Engine->GetTypeInfoById(RefTypeId);
+			if (Type != nullptr)
+				Type->AddRef();
+		}
+
+		Target.TypeId = RefTypeId;
+		if (Target.TypeId & asTYPEID_OBJHANDLE)
+		{
+			Target.Object = *(void**)RefPointer;
+			if (Target.Object != nullptr)
+				Engine->AddRefScriptObject(Target.Object, Engine->GetTypeInfoById(Target.TypeId));
+		}
+		else if (Target.TypeId & asTYPEID_MASK_OBJECT)
+		{
+			Target.Object = Engine->CreateScriptObjectCopy(RefPointer, Engine->GetTypeInfoById(Target.TypeId));
+		}
+		else if (RefPointer != nullptr)
+		{
+			Target.Integer = 0;
+			int Size = Engine->GetSizeOfPrimitiveType(Target.TypeId);
+			memcpy(&Target.Integer, RefPointer, Size);
+		}
+	}
+	/* Copy or reference stored value into output */
+	bool Extract(Dynamic& Source, void* RefPointer, int RefTypeId)
+	{
+		if (Source.TypeId == PROMISE_NULLID || Source.TypeId == asTYPEID_VOID)
+			return false;
+
+		if (RefTypeId & asTYPEID_OBJHANDLE)
+		{
+			if ((Source.TypeId & asTYPEID_MASK_OBJECT))
+			{
+				if ((Source.TypeId & asTYPEID_HANDLETOCONST) && !(RefTypeId & asTYPEID_HANDLETOCONST))
+					return false;
+
+				Engine->RefCastObject(Source.Object, Engine->GetTypeInfoById(Source.TypeId), Engine->GetTypeInfoById(RefTypeId), reinterpret_cast<void**>(RefPointer));
+				if (*(asPWORD*)RefPointer == 0)
+					return false;
+
+				return true;
+			}
+		}
+		else if (RefTypeId & asTYPEID_MASK_OBJECT)
+		{
+			if (Source.TypeId == RefTypeId)
+			{
+				Engine->AssignScriptObject(RefPointer, Source.Object, Engine->GetTypeInfoById(Source.TypeId));
+				return true;
+			}
+		}
+		else
+		{
+			int Size1 = Engine->GetSizeOfPrimitiveType(Source.TypeId);
+			int Size2 = Engine->GetSizeOfPrimitiveType(RefTypeId);
+			PROMISE_ASSERT(Size1 == Size2, "cannot map incompatible primitive types");
+
+			if (Size1 == Size2)
+			{
+				memcpy(RefPointer, &Source.Integer, Size1);
+				return true;
+			}
+		}
+
+		return false;
+	}
+	/* Address of stored value as expected by script engine */
+	static void* GetAddressOf(Dynamic& Source)
+	{
+		if (Source.TypeId & asTYPEID_OBJHANDLE)
+			return &Source.Object;
+		else if (Source.TypeId & asTYPEID_MASK_OBJECT)
+			return Source.Object;
+		else if (Source.TypeId <= asTYPEID_DOUBLE || Source.TypeId & asTYPEID_MASK_SEQNBR)
+			return &Source.Integer;
+
+		return nullptr;
+	}
+	/*
+		Execute continuation inline, context that is active on this thread is reused
+		through nested call, otherwise context is taken from pool once by the first
+		stage and reused by every stage it settles, so a chain takes one context
+	*/
+	template <typename Arguments, typename Completion>
+	static void ExecuteInline(asIScriptFunction* Callback, Arguments&& Setup, Completion&& Complete)
+	{
+		static thread_local asIScriptContext* Reusable = nullptr;
+		asIScriptEngine* ThisEngine = Callback->GetEngine();
+		asIScriptContext* Outer = Reusable;
+		asIScriptContext* Inline = asGetActiveContext();
+		bool Nested = Inline != nullptr && Inline->GetEngine() == ThisEngine && Inline->PushState() >= 0;
+		bool Owned = false;
+		if (!Nested)
+		{
+			if (Outer != nullptr && Outer->GetEngine() == ThisEngine && Outer->GetState() != asEXECUTION_ACTIVE)
+				Inline = Outer;
+			else
+			{
+				Inline = ThisEngine->RequestContext();
+				Reusable = Inline;
+				Owned = true;
+			}
+		}
+
+		int Status = Inline->Prepare(Callback);
+		if (Status >= 0)
+			Status = Setup(Inline);
+		if (Status >= 0)
+			Status = Inline->Execute();
+		if (Status == asEXECUTION_SUSPENDED)
+			Inline->Abort();
+
+		Complete(Inline, Status);
+		if (Nested)
+			Inline->PopState();
+		else if (Owned)
+		{
+			Reusable = Outer;
+			ThisEngine->ReturnContext(Inline);
+		}
+	}
+	/* Own script function (and delegate) until last continuation copy is destroyed */
+	static std::shared_ptr<asIScriptFunction> Retain(asIScriptFunction* Callback)
+	{
+		void* DelegateObject = Callback->GetDelegateObject();
+		if (DelegateObject != nullptr)
+			Callback->GetEngine()->AddRefScriptObject(DelegateObject, Callback->GetDelegateObjectType());
+
+		return std::shared_ptr<asIScriptFunction>(Callback, &AsClearCallback);
+	}
+	/* Reset value to none */
+	void Clean()
+	{
+		memset(&Value, 0, sizeof(Value));
+		Value.TypeId = PROMISE_NULLID;
+	}
+
+public:
+	/* AsBasicPromise creation function, for use within C++ */
+	static AsBasicPromise* Create(asIScriptContext* Context = asGetActiveContext())
+	{
+		return new(asAllocMem(sizeof(AsBasicPromise))) AsBasicPromise(Context);
+	}
+	/*
+		Lazy promise creation function, producer is called with this promise
+		when it is first awaited or queried and should settle it (now or later)
+	*/
+	static AsBasicPromise* Create(std::function<void(AsBasicPromise<Executor>*)>&& Producer, asIScriptContext* Context = asGetActiveContext())
+	{
+		PROMISE_ASSERT(Producer, "producer should not be empty");
+		AsBasicPromise* Future = Create(Context);
+		Future->GetExtension()->Producer = std::move(Producer);
+		Future->State.Set(AsPromiseState::Lazy);
+		return Future;
+	}
+	/* AsBasicPromise creation function, for use within AngelScript */
+	static AsBasicPromise* CreateFactory(void* _Ref, int TypeId)
+	{
+		AsBasicPromise* Future = new(asAllocMem(sizeof(AsBasicPromise))) AsBasicPromise(asGetActiveContext());
+		if (TypeId != asTYPEID_VOID)
+			Future->Store(_Ref, TypeId);
+
+		return Future;
+	}
+	/* AsBasicPromise creation function, for use within AngelScript (void promise) */
+	static AsBasicPromise* CreateFactoryVoid(void*, int)
+	{
+		return Create();
+	}
+	/*
+		Interface registration, note: promise<void> is not supported,
+		instead use promise_v when internal datatype is not intended,
+		promise will be an object handle with GC behaviours, default
+		constructed promise will be pending otherwise early settled
+	*/
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsBasicPromise<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_TYPENAME "<class T>", 0, asOBJ_REF | asOBJ_GC | asOBJ_TEMPLATE));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_FACTORY, PROMISE_TYPENAME "<T>@ f(?&in)", asFUNCTION(Type::CreateFactory), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_TEMPLATE_CALLBACK, "bool f(int&in, bool&out)", asFUNCTION(Type::TemplateCallback), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_SETGCFLAG, "void f()", asMETHOD(Type, MarkRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_GETGCFLAG, "bool f()", asMETHOD(Type, IsRefMarked), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_GETREFCOUNT, "int f()", asMETHOD(Type, GetRefCount), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_ENUMREFS, "void f(int&in)", asMETHOD(Type, EnumReferences), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_RELEASEREFS, "void f(int&in)", asMETHOD(Type, ReleaseReferences), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "void " PROMISE_WRAP "(?&in)", asMETHODPR(Type, Store, (void*, int), void), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "T& " PROMISE_UNWRAP "()", asMETHODPR(Type, Retrieve, (), void*), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", PROMISE_TYPENAME "<T>@+ " PROMISE_YIELD "()", asMETHOD(Type, YieldIf), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "bool " PROMISE_PENDING "()", asMETHOD(Type, Poll), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "void " PROMISE_REJECT "(int)", asMETHOD(Type, RejectCode), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "void " PROMISE_REJECT "(int, ?&in)", asMETHODPR(Type, Reject, (int, void*, int), void), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "bool " PROMISE_FAILED "()", asMETHOD(Type, IsFailed), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "int " PROMISE_ERRORCODE "()", asMETHOD(Type, GetErrorCode), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "bool " PROMISE_ERRORDETAIL "(?&out)", asMETHOD(Type, RetrieveError), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "T " PROMISE_UNWRAPOR "(const T&in)", asFUNCTION(Type::RetrieveOrGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterFuncdef("T " PROMISE_TYPENAME "<T>::" PROMISE_MAPEVENT "(const T&in)"));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", PROMISE_TYPENAME "<T>@ " PROMISE_MAP "(" PROMISE_MAPEVENT "@)", asMETHOD(Type, MapInline), asCALL_THISCALL));
+#if PROMISE_CALLBACKS
+		PROMISE_CHECK(Engine->RegisterFuncdef("void " PROMISE_TYPENAME "<T>::" PROMISE_EVENT "(promise<T>@+)"));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "void " PROMISE_WHEN "(" PROMISE_EVENT "@)", asMETHODPR(Type, When, (asIScriptFunction*), void), asCALL_THISCALL));
+#endif
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, 0, asOBJ_REF | asOBJ_GC));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_FACTORY, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ f()", asFUNCTION(Type::CreateFactoryVoid), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_SETGCFLAG, "void f()", asMETHOD(Type, MarkRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_GETGCFLAG, "bool f()", asMETHOD(Type, IsRefMarked), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_GETREFCOUNT, "int f()", asMETHOD(Type, GetRefCount), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_ENUMREFS, "void f(int&in)", asMETHOD(Type, EnumReferences), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_RELEASEREFS, "void f(int&in)", asMETHOD(Type, ReleaseReferences), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_WRAP "()", asMETHODPR(Type, StoreVoid, (), void), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_UNWRAP "()", asMETHODPR(Type, RetrieveVoid, (), void), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@+ " PROMISE_YIELD "()", asMETHOD(Type, YieldIf), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "bool " PROMISE_PENDING "()", asMETHOD(Type, Poll), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_REJECT "(int)", asMETHOD(Type, RejectCode), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_REJECT "(int, ?&in)", asMETHODPR(Type, Reject, (int, void*, int), void), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "bool " PROMISE_FAILED "()", asMETHOD(Type, IsFailed), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "int " PROMISE_ERRORCODE "()", asMETHOD(Type, GetErrorCode), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "bool " PROMISE_ERRORDETAIL "(?&out)", asMETHOD(Type, RetrieveError), asCALL_THISCALL));
+#if PROMISE_CALLBACKS
+		PROMISE_CHECK(Engine->RegisterFuncdef("void " PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "::" PROMISE_EVENT "(promise_v@+)"));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_WHEN "(" PROMISE_EVENT "@)", asMETHODPR(Type, When, (asIScriptFunction*), void), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_THEN "(" PROMISE_EVENT "@)", asMETHOD(Type, ThenInline), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_THEN "(" PROMISE_EVENT "@)", asMETHOD(Type, ThenInline), asCALL_THISCALL));
+#endif
+#if PROMISE_METRICS
+		Engine->SetContextUserDataCleanupCallback(&AsPromiseMetrics::Cleanup, PROMISE_USERID + 10);
+#endif
+#if PROMISE_REGISTRY
+		Engine->SetContextUserDataCleanupCallback(&AsPromiseRegistry::Cleanup, PROMISE_USERID + 12);
+#endif
+	}
+
+private:
+	/*
+		Script <unwrap_or> implementation, generic calling convention is used
+		because return type is template subtype returned by value, default
+		is returned when promise is still pending or was rejected, value is
+		copied after unlock as copying may run script and fulfilled value
+		never changes while promise is referenced by this call
+	*/
+	static void RetrieveOrGeneric(asIScriptGeneric* Generic)
+	{
+		AsBasicPromise* Base = (AsBasicPromise*)Generic->GetObject();
+		std::unique_lock<AsPromiseState> Unique(Base->State);
+		void* Source = (Base->IsPending() || Base->IsFailed()) ? Generic->GetArgAddress(0) : GetAddressOf(Base->Value);
+		Unique.unlock();
+
+		int TypeId = Generic->GetReturnTypeId();
+		if (TypeId & asTYPEID_OBJHANDLE)
+			Generic->SetReturnObject(*(void**)Source);
+		else if (TypeId & asTYPEID_MASK_OBJECT)
+			Generic->SetReturnObject(Source);
+		else
+			memcpy(Generic->GetAddressOfReturnLocation(), Source, Generic->GetEngine()->GetSizeOfPrimitiveType(TypeId));
+	}
+	/* Template callback function for compiler, copy-paste from <array> class */
+	static bool TemplateCallback(asITypeInfo* Info, bool& DontGarbageCollect)
+	{
+		int TypeId = Info->GetSubTypeId();
+		if (TypeId == asTYPEID_VOID)
+			return false;
+
+		if ((TypeId & asTYPEID_MASK_OBJECT) && !(TypeId & asTYPEID_OBJHANDLE))
+		{
+			asIScriptEngine* Engine = Info->GetEngine();
+			asITypeInfo* SubType = Engine->GetTypeInfoById(TypeId);
+			asQWORD Flags = SubType->GetFlags();
+
+			if ((Flags & asOBJ_VALUE) && !(Flags & asOBJ_POD))
+			{
+				bool Found = false;
+				for (size_t i = 0; i < SubType->GetBehaviourCount(); i++)
+				{
+					asEBehaviours Behaviour;
+					asIScriptFunction* Func = SubType->GetBehaviourByIndex((int)i, &Behaviour);
+					if (Behaviour != asBEHAVE_CONSTRUCT)
+						continue;
+
+					if (Func->GetParamCount() == 0)
+					{
+						Found = true;
+						break;
+					}
+				}
+
+				if (!Found)
+				{
+					Engine->WriteMessage(PROMISE_TYPENAME, 0, 0, asMSGTYPE_ERROR, "The subtype has no default constructor");
+					return false;
+				}
+			}
+			else if ((Flags & asOBJ_REF))
+			{
+				bool Found = false;
+				if (!Engine->GetEngineProperty(asEP_DISALLOW_VALUE_ASSIGN_FOR_REF_TYPE))
+				{
+					for (size_t i = 0; i < SubType->GetFactoryCount(); i++)
+					{
+						asIScriptFunction* Function = SubType->GetFactoryByIndex((int)i);
+						if (Function->GetParamCount() == 0)
+						{
+							Found = true;
+							break;
+						}
+					}
+				}
+
+				if (!Found)
+				{
+					Engine->WriteMessage(PROMISE_TYPENAME, 0, 0, asMSGTYPE_ERROR, "The subtype has no default factory");
+					return false;
+				}
+			}
+
+			if (!(Flags & asOBJ_GC))
+				DontGarbageCollect = true;
+		}
+		else if (!(TypeId & asTYPEID_OBJHANDLE))
+		{
+			DontGarbageCollect = true;
+		}
+		else
+		{
+			asITypeInfo* SubType = Info->GetEngine()->GetTypeInfoById(TypeId);
+			asQWORD Flags = SubType->GetFlags();
+
+			if (!(Flags & asOBJ_GC))
+			{
+				if ((Flags & asOBJ_SCRIPT_OBJECT))
+				{
+					if ((Flags & asOBJ_NOINHERIT))
+						DontGarbageCollect = true;
+				}
+				else
+					DontGarbageCollect = true;
+			}
+		}
+
+		return true;
+	}
+};
+
+#ifndef AS_PROMISE_NO_SYNCHRONIZATION
+#include <deque>
+#include <errno.h>
+/*
+	Base of coroutine aware synchronization primitives, waiters are
+	pending void promises kept in FIFO order, awaiting such promise
+	suspends the context through usual <yield> machinery
+*/
+template <typename Executor, typename Primitive>
+class AsAsyncPrimitive
+{
+protected:
+	typedef AsBasicPromise<Executor> Promise;
+
+protected:
+	std::deque<Promise*> Waiters;
+	std::atomic<uint32_t> RefCount;
+	std::mutex Update;
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		PROMISE_ASSERT(RefCount > 0, "primitive is already released");
+		if (!--RefCount)
+		{
+			Primitive* Base = (Primitive*)this;
+			Base->~Primitive();
+			asFreeMem((void*)Base);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		++RefCount;
+	}
+
+protected:
+	AsAsyncPrimitive() noexcept : RefCount(1)
+	{
+	}
+	~AsAsyncPrimitive()
+	{
+		/* Contexts that still wait would never be resumed, their promises are cancelled */
+		std::deque<Promise*> Queue;
+		Queue.swap(Waiters);
+		for (auto* Waiter : Queue)
+		{
+			Waiter->RejectCode(ECANCELED);
+			Waiter->Release();
+		}
+	}
+	/* Create a pending promise and put it at the end of the queue, must be called under lock */
+	Promise* Enqueue(asIScriptContext* Context)
+	{
+		Promise* Future = Promise::Create(Context);
+		Future->AddRef();
+		Waiters.push_back(Future);
+		return Future;
+	}
+	/* Take first waiter from the queue, must be called under lock */
+	Promise* Dequeue()
+	{
+		Promise* Future = Waiters.front();
+		Waiters.pop_front();
+		return Future;
+	}
+
+protected:
+	/* Create an already settled promise, awaiting it never suspends */
+	static Promise* Settled(asIScriptContext* Context)
+	{
+		Promise* Future = Promise::Create(Context);
+		Future->StoreVoid();
+		return Future;
+	}
+	/* Settle dequeued waiter, must be called without lock as it may resume the context in-place */
+	static void Resolve(Promise* Future)
+	{
+		Future->StoreVoid();
+		Future->Release();
+	}
+	static Primitive* Allocate()
+	{
+		return new(asAllocMem(sizeof(Primitive))) Primitive();
+	}
+	template <typename Type>
+	static void RegisterBase(asIScriptEngine* Engine, const char* TypeName)
+	{
+		PROMISE_CHECK(Engine->RegisterObjectType(TypeName, 0, asOBJ_REF));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(TypeName, asBEHAVE_ADDREF, "void f()", asMETHODPR(Type, AddRef, (), void), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(TypeName, asBEHAVE_RELEASE, "void f()", asMETHODPR(Type, Release, (), void), asCALL_THISCALL));
+	}
+};
+
+/*
+	Mutex that suspends awaiting context instead of blocking the thread,
+	unlock hands ownership directly to the next waiter in FIFO order
+*/
+template <typename Executor>
+class AsAsyncMutex : public AsAsyncPrimitive<Executor, AsAsyncMutex<Executor>>
+{
+	friend AsAsyncPrimitive<Executor, AsAsyncMutex<Executor>>;
+	typedef AsBasicPromise<Executor> Promise;
+
+private:
+	bool Locked = false;
+
+public:
+	/* Returned promise is settled when the lock is owned by caller */
+	Promise* Lock(asIScriptContext* Context = asGetActiveContext())
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		if (Locked)
+			return this->Enqueue(Context);
+
+		Locked = true;
+		Unique.unlock();
+		return this->Settled(Context);
+	}
+	/* Take the lock only if it is free */
+	bool TryLock()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		if (Locked)
+			return false;
+
+		Locked = true;
+		return true;
+	}
+	/* Release the lock or pass it to the next waiter, unlocking free mutex raises script exception */
+	void Unlock()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		if (!Locked)
+		{
+			Unique.unlock();
+			asIScriptContext* Context = asGetActiveContext();
+			if (Context != nullptr)
+				Context->SetException("mutex is not locked");
+			return;
+		}
+
+		if (this->Waiters.empty())
+		{
+			Locked = false;
+			return;
+		}
+
+		Promise* Next = this->Dequeue();
+		Unique.unlock();
+		this->Resolve(Next);
+	}
+	bool IsLocked()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		return Locked;
+	}
+
+public:
+	static AsAsyncMutex* Create()
+	{
+		return AsAsyncMutex::Allocate();
+	}
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsAsyncMutex<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		Type::template RegisterBase<Type>(Engine, PROMISE_MUTEX);
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_MUTEX, asBEHAVE_FACTORY, PROMISE_MUTEX "@ f()", asFUNCTION(Type::Create), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_MUTEX, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ lock()", asFUNCTION(Type::LockFactory), asCALL_CDECL_OBJFIRST));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_MUTEX, "bool try_lock()", asMETHOD(Type, TryLock), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_MUTEX, "void unlock()", asMETHOD(Type, Unlock), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_MUTEX, "bool locked()", asMETHOD(Type, IsLocked), asCALL_THISCALL));
+	}
+
+private:
+	static Promise* LockFactory(AsAsyncMutex* Base)
+	{
+		return Base->Lock();
+	}
+};
+
+/*
+	Counting semaphore for coroutines, release hands
+	a permit directly to the next waiter in FIFO order
+*/
+template <typename Executor>
+class AsAsyncSemaphore : public AsAsyncPrimitive<Executor, AsAsyncSemaphore<Executor>>
+{
+	friend AsAsyncPrimitive<Executor, AsAsyncSemaphore<Executor>>;
+	typedef AsBasicPromise<Executor> Promise;
+
+private:
+	uint32_t Permits = 0;
+
+public:
+	/* Returned promise is settled when a permit is owned by caller */
+	Promise* Acquire(asIScriptContext* Context = asGetActiveContext())
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		if (!Permits || !this->Waiters.empty())
+			return this->Enqueue(Context);
+
+		--Permits;
+		Unique.unlock();
+		return this->Settled(Context);
+	}
+	/* Take a permit only if one is available */
+	bool TryAcquire()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		if (!Permits)
+			return false;
+
+		--Permits;
+		return true;
+	}
+	/* Return permits, waiters are served first */
+	void Signal(uint32_t Count = 1)
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		while (Count > 0 && !this->Waiters.empty())
+		{
+			Promise* Next = this->Dequeue();
+			Unique.unlock();
+			this->Resolve(Next);
+			Unique.lock();
+			--Count;
+		}
+		Permits += Count;
+	}
+	uint32_t GetPermits()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		return Permits;
+	}
+
+public:
+	static AsAsyncSemaphore* Create(uint32_t Permits)
+	{
+		AsAsyncSemaphore* Result = AsAsyncSemaphore::Allocate();
+		Result->Permits = Permits;
+		return Result;
+	}
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsAsyncSemaphore<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		Type::template RegisterBase<Type>(Engine, PROMISE_SEMAPHORE);
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_SEMAPHORE, asBEHAVE_FACTORY, PROMISE_SEMAPHORE "@ f(uint)", asFUNCTION(Type::Create), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SEMAPHORE, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ acquire()", asFUNCTION(Type::AcquireFactory), asCALL_CDECL_OBJFIRST));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SEMAPHORE, "bool try_acquire()", asMETHOD(Type, TryAcquire), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SEMAPHORE, "void release(uint = 1)", asMETHOD(Type, Signal), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SEMAPHORE, "uint permits()", asMETHOD(Type, GetPermits), asCALL_THISCALL));
+	}
+
+private:
+	static Promise* AcquireFactory(AsAsyncSemaphore* Base)
+	{
+		return Base->Acquire();
+	}
+};
+
+/*
+	Manual reset event for coroutines, all
+	waiters are resumed when event is set
+*/
+template <typename Executor>
+class AsAsyncEvent : public AsAsyncPrimitive<Executor, AsAsyncEvent<Executor>>
+{
+	friend AsAsyncPrimitive<Executor, AsAsyncEvent<Executor>>;
+	typedef AsBasicPromise<Executor> Promise;
+
+private:
+	bool Signaled = false;
+
+public:
+	/* Returned promise is settled when event is set */
+	Promise* Wait(asIScriptContext* Context = asGetActiveContext())
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		if (!Signaled)
+			return this->Enqueue(Context);
+
+		Unique.unlock();
+		return this->Settled(Context);
+	}
+	/* Signal the event and resume every waiter */
+	void Set()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		Signaled = true;
+		std::deque<Promise*> Queue;
+		Queue.swap(this->Waiters);
+		Unique.unlock();
+
+		for (auto* Next : Queue)
+			this->Resolve(Next);
+	}
+	/* Unsignal the event, next waiters will be suspended */
+	void Reset()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		Signaled = false;
+	}
+	bool IsSet()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		return Signaled;
+	}
+
+public:
+	static AsAsyncEvent* Create()
+	{
+		return AsAsyncEvent::Allocate();
+	}
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsAsyncEvent<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		Type::template RegisterBase<Type>(Engine, PROMISE_EVENTTYPE);
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_EVENTTYPE, asBEHAVE_FACTORY, PROMISE_EVENTTYPE "@ f()", asFUNCTION(Type::Create), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_EVENTTYPE, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ wait()", asFUNCTION(Type::WaitFactory), asCALL_CDECL_OBJFIRST));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_EVENTTYPE, "void set()", asMETHOD(Type, Set), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_EVENTTYPE, "void reset()", asMETHOD(Type, Reset), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_EVENTTYPE, "bool is_set()", asMETHOD(Type, IsSet), asCALL_THISCALL));
+	}
+
+private:
+	static Promise* WaitFactory(AsAsyncEvent* Base)
+	{
+		return Base->Wait();
+	}
+};
+
+/*
+	Reusable barrier for coroutines, last arriving
+	participant resumes all waiters of current phase
+*/
+template <typename Executor>
+class AsAsyncBarrier : public AsAsyncPrimitive<Executor, AsAsyncBarrier<Executor>>
+{
+	friend AsAsyncPrimitive<Executor, AsAsyncBarrier<Executor>>;
+	typedef AsBasicPromise<Executor> Promise;
+
+private:
+	uint32_t Expected = 1;
+	uint32_t Arrived = 0;
+
+public:
+	/* Returned promise is settled when all participants have arrived */
+	Promise* ArriveAndWait(asIScriptContext* Context = asGetActiveContext())
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		if (++Arrived < Expected)
+			return this->Enqueue(Context);
+
+		Arrived = 0;
+		std::deque<Promise*> Queue;
+		Queue.swap(this->Waiters);
+		Unique.unlock();
+
+		for (auto* Next : Queue)
+			this->Resolve(Next);
+
+		return this->Settled(Context);
+	}
+	uint32_t GetArrived()
+	{
+		std::unique_lock<std::mutex> Unique(this->Update);
+		return Arrived;
+	}
+
+public:
+	static AsAsyncBarrier* Create(uint32_t Expected)
+	{
+		if (!Expected)
+		{
+			asIScriptContext* Context = asGetActiveContext();
+			if (Context != nullptr)
+				Context->SetException("barrier should expect at least one participant");
+			return nullptr;
+		}
+
+		AsAsyncBarrier* Result = AsAsyncBarrier::Allocate();
+		Result->Expected = Expected;
+		return Result;
+	}
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsAsyncBarrier<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		Type::template RegisterBase<Type>(Engine, PROMISE_BARRIER);
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_BARRIER, asBEHAVE_FACTORY, PROMISE_BARRIER "@ f(uint)", asFUNCTION(Type::Create), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_BARRIER, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ arrive_and_wait()", asFUNCTION(Type::ArriveFactory), asCALL_CDECL_OBJFIRST));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_BARRIER, "uint arrived()", asMETHOD(Type, GetArrived), asCALL_THISCALL));
+	}
+
+private:
+	static Promise* ArriveFactory(AsAsyncBarrier* Base)
+	{
+		return Base->ArriveAndWait();
+	}
+};
+
+/* Register all synchronization primitives, promise interface should be registered first */
+template <typename Executor>
+static void AsRegisterSynchronization(asIScriptEngine* Engine)
+{
+	AsAsyncMutex<Executor>::Register(Engine);
+	AsAsyncSemaphore<Executor>::Register(Engine);
+	AsAsyncEvent<Executor>::Register(Engine);
+	AsAsyncBarrier<Executor>::Register(Engine);
+}
+#endif
+#ifndef AS_PROMISE_NO_TASKS
+#include <deque>
+template <typename Executor>
+class AsTaskGroup;
+
+/*
+	Script functions started on pooled contexts, function runs eagerly until
+	it's first suspension or return, returned promise is settled when function
+	finishes, executors should resume contexts with AsExecuteContext to notice that
+*/
+template <typename Executor>
+class AsSpawner
+{
+	friend AsTaskGroup<Executor>;
+
+private:
+	typedef AsBasicPromise<Executor> Promise;
+	struct Argument
+	{
+		asQWORD Integer = 0;
+		void* Object = nullptr;
+		int TypeId = 0;
+	};
+	struct Task : AsContextHook
+	{
+		std::vector<Argument> Arguments;
+		asIScriptFunction* Function = nullptr;
+		asIScriptEngine* Engine = nullptr;
+		AsTaskGroup<Executor>* Group = nullptr;
+		Promise* Future = nullptr;
+	};
+
+public:
+	/* spawn(function, arguments...) */
+	static void SpawnGeneric(asIScriptGeneric* Generic)
+	{
+		Task* Next = Capture(Generic, nullptr);
+		if (!Next)
+			return;
+
+		Promise* Future = Next->Future;
+		Future->AddRef();
+		Run(Next);
+		Generic->SetReturnAddress(Future);
+	}
+	/* Register spawn function, promise interface should be registered first */
+	static void Register(asIScriptEngine* Engine)
+	{
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in)", asFUNCTION(AsSpawner::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in)", asFUNCTION(AsSpawner::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in, ?&in)", asFUNCTION(AsSpawner::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in, ?&in, ?&in)", asFUNCTION(AsSpawner::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in, ?&in, ?&in, ?&in)", asFUNCTION(AsSpawner::SpawnGeneric), asCALL_GENERIC));
+	}
+
+private:
+	/* Copy function handle and arguments of generic call, sets script exception on mismatch */
+	static Task* Capture(asIScriptGeneric* Generic, AsTaskGroup<Executor>* Group)
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		asIScriptEngine* Engine = Generic->GetEngine();
+		int TypeId = Generic->GetArgTypeId(0);
+		asITypeInfo* Type = Engine->GetTypeInfoById(TypeId);
+		if (!Type || !(Type->GetFlags() & asOBJ_FUNCDEF))
+		{
+			Context->SetException(PROMISE_SPAWN " expects a function handle");
+			return nullptr;
+		}
+
+		void* Address = Generic->GetArgAddress(0);
+		asIScriptFunction* Function = (TypeId & asTYPEID_OBJHANDLE) ? *(asIScriptFunction**)Address : (asIScriptFunction*)Address;
+		asUINT Count = (asUINT)Generic->GetArgCount() - 1;
+		if (!Function || Function->GetParamCount() != Count)
+		{
+			Context->SetException(PROMISE_SPAWN " function is null or has different arguments count");
+			return nullptr;
+		}
+
+		if (Function->GetReturnTypeId() != asTYPEID_VOID)
+		{
+			Context->SetException(PROMISE_SPAWN " function should return void (return value would be lost)");
+			return nullptr;
+		}
+
+		for (asUINT i = 0; i < Count; i++)
+		{
+			int ParamTypeId; asDWORD Flags;
+			Function->GetParam(i, &ParamTypeId, &Flags);
+			int ArgTypeId = Generic->GetArgTypeId(i + 1);
+			int Mask = ~(asTYPEID_OBJHANDLE | asTYPEID_HANDLETOCONST);
+			if ((Flags & asTM_OUTREF) || (ParamTypeId & Mask) != (ArgTypeId & Mask))
+			{
+				Context->SetException(PROMISE_SPAWN " argument type mismatch (output references are not allowed)");
+				return nullptr;
+			}
+		}
+
+		Task* Next = new(asAllocMem(sizeof(Task))) Task();
+		Next->Finish = &AsSpawner::Finish;
+		Next->Engine = Engine;
+		Next->Function = Function;
+		Next->Function->AddRef();
+		Next->Future = Promise::Create(Context);
+		Next->Group = Group;
+		if (Group != nullptr)
+			Group->AddRef();
+
+		Next->Arguments.resize(Count);
+		for (asUINT i = 0; i < Count; i++)
+		{
+			int ParamTypeId; asDWORD Flags;
+			Function->GetParam(i, &ParamTypeId, &Flags);
+			Argument& Target = Next->Arguments[i];
+			void* Source = Generic->GetArgAddress(i + 1);
+			int ArgTypeId = Generic->GetArgTypeId(i + 1);
+			Target.TypeId = ParamTypeId;
+			if (ParamTypeId & asTYPEID_MASK_OBJECT)
+			{
+				asITypeInfo* ArgType = Engine->GetTypeInfoById(ParamTypeId);
+				void* Object = (ArgTypeId & asTYPEID_OBJHANDLE) ? *(void**)Source : Source;
+				if (Object != nullptr && (ParamTypeId & asTYPEID_OBJHANDLE))
+				{
+					Target.Object = Object;
+					Engine->AddRefScriptObject(Object, ArgType);
+				}
+				else if (Object != nullptr)
+					Target.Object = Engine->CreateScriptObjectCopy(Object, ArgType);
+			}
+			else
+				memcpy(&Target.Integer, Source, (size_t)Engine->GetSizeOfPrimitiveType(ParamTypeId));
+		}
+
+		return Next;
+	}
+	/* Start task on pooled context, finishes it immediately if context cannot be prepared */
+	static void Run(Task* Next)
+	{
+		asIScriptContext* Context = Next->Engine->RequestContext();
+		if (!Context)
+			return Finish(Next, nullptr, asEXECUTION_ERROR);
+
+		if (Context->Prepare(Next->Function) < 0 || !Bind(Next, Context))
+			return Finish(Next, Context, asEXECUTION_ERROR);
+
+		Context->SetUserData((void*)(AsContextHook*)Next, PROMISE_USERID + 5);
+		AsExecuteContext(Context);
+	}
+	static bool Bind(Task* Next, asIScriptContext* Context)
+	{
+		for (asUINT i = 0; i < (asUINT)Next->Arguments.size(); i++)
+		{
+			Argument& Source = Next->Arguments[i];
+			int ParamTypeId; asDWORD Flags;
+			Next->Function->GetParam(i, &ParamTypeId, &Flags);
+
+			int Status;
+			if (ParamTypeId & asTYPEID_MASK_OBJECT)
+				Status = (Flags & asTM_INREF) ? Context->SetArgAddress(i, Source.Object) : Context->SetArgObject(i, Source.Object);
+			else if (Flags & asTM_INREF)
+				Status = Context->SetArgAddress(i, &Source.Integer);
+			else if (ParamTypeId == asTYPEID_FLOAT)
+				Status = Context->SetArgFloat(i, *(float*)&Source.Integer);
+			else if (ParamTypeId == asTYPEID_DOUBLE)
+				Status = Context->SetArgDouble(i, *(double*)&Source.Integer);
+			else switch (Next->Engine->GetSizeOfPrimitiveType(ParamTypeId))
+			{
+				case 1:
+					Status = Context->SetArgByte(i, *(asBYTE*)&Source.Integer);
+					break;
+				case 2:
+					Status = Context->SetArgWord(i, *(asWORD*)&Source.Integer);
+					break;
+				case 4:
+					Status = Context->SetArgDWord(i, *(asDWORD*)&Source.Integer);
+					break;
+				default:
+					Status = Context->SetArgQWord(i, Source.Integer);
+					break;
+			}
+
+			if (Status < 0)
+				return false;
+		}
+		return true;
+	}
+	/* Return context to pool, release captured state and settle promise, may start next task of a group */
+	static void Finish(AsContextHook* Hook, asIScriptContext* Context, int Status)
+	{
+		Task* Next = (Task*)Hook;
+		asIScriptEngine* Engine = Next->Engine;
+		if (Context != nullptr)
+			Engine->ReturnContext(Context);
+
+		for (auto& Source : Next->Arguments)
+		{
+			if (Source.Object != nullptr)
+				Engine->ReleaseScriptObject(Source.Object, Engine->GetTypeInfoById(Source.TypeId));
+		}
+
+		Promise* Future = Next->Future;
+		AsTaskGroup<Executor>* Group = Next->Group;
+		Next->Function->Release();
+		Next->~Task();
+		asFreeMem((void*)Next);
+
+		if (Status == asEXECUTION_FINISHED)
+			Future->StoreVoid();
+		else
+			Future->RejectCode(PROMISE_SPAWN_ERROR);
+		Future->Release();
+
+		if (Group != nullptr)
+		{
+			Group->OnFinish();
+			Group->Release();
+		}
+	}
+};
+
+/*
+	Group of spawned functions with concurrency limit, functions over the limit wait
+	in FIFO order, join promise is settled when every function has finished and
+	returned it's context to the pool
+*/
+template <typename Executor>
+class AsTaskGroup
+{
+	friend AsSpawner<Executor>;
+
+private:
+	typedef AsBasicPromise<Executor> Promise;
+	typedef typename AsSpawner<Executor>::Task Task;
+
+private:
+	std::deque<Task*> Queue;
+	std::vector<Promise*> Joiners;
+	std::atomic<uint32_t> RefCount;
+	std::mutex Update;
+	uint32_t Limit;
+	uint32_t Running;
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		PROMISE_ASSERT(RefCount > 0, "task group is already released");
+		if (!--RefCount)
+		{
+			this->~AsTaskGroup();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		++RefCount;
+	}
+	/* Settled when all functions spawned so far have finished */
+	Promise* Join()
+	{
+		Promise* Future = Promise::Create();
+		std::unique_lock<std::mutex> Unique(Update);
+		if (Running > 0 || !Queue.empty())
+		{
+			Future->AddRef();
+			Joiners.push_back(Future);
+			return Future;
+		}
+
+		Unique.unlock();
+		Future->StoreVoid();
+		return Future;
+	}
+	uint32_t GetRunning()
+	{
+		std::unique_lock<std::mutex> Unique(Update);
+		return Running;
+	}
+	uint32_t GetQueued()
+	{
+		std::unique_lock<std::mutex> Unique(Update);
+		return (uint32_t)Queue.size();
+	}
+
+private:
+	AsTaskGroup(uint32_t NewLimit) noexcept : RefCount(1), Limit(NewLimit), Running(0)
+	{
+	}
+	~AsTaskGroup()
+	{
+		PROMISE_ASSERT(Queue.empty() && Joiners.empty(), "task group is destroyed while tasks are pending");
+	}
+	void Enqueue(Task* Next)
+	{
+		std::unique_lock<std::mutex> Unique(Update);
+		if (Limit > 0 && Running >= Limit)
+			return Queue.push_back(Next);
+
+		++Running;
+		Unique.unlock();
+		AsSpawner<Executor>::Run(Next);
+	}
+	void OnFinish()
+	{
+		std::unique_lock<std::mutex> Unique(Update);
+		--Running;
+		if (!Queue.empty())
+		{
+			Task* Next = Queue.front();
+			Queue.pop_front();
+			++Running;
+			Unique.unlock();
+			return AsSpawner<Executor>::Run(Next);
+		}
+		else if (Running > 0)
+			return;
+
+		std::vector<Promise*> Ready;
+		Ready.swap(Joiners);
+		Unique.unlock();
+		for (auto* Future : Ready)
+		{
+			Future->StoreVoid();
+			Future->Release();
+		}
+	}
+
+public:
+	static AsTaskGroup* Create(uint32_t Limit)
+	{
+		return new(asAllocMem(sizeof(AsTaskGroup))) AsTaskGroup(Limit);
+	}
+	/* task_group.spawn(function, arguments...) */
+	static void SpawnGeneric(asIScriptGeneric* Generic)
+	{
+		AsTaskGroup* Base = (AsTaskGroup*)Generic->GetObject();
+		Task* Next = AsSpawner<Executor>::Capture(Generic, Base);
+		if (!Next)
+			return;
+
+		Promise* Future = Next->Future;
+		Future->AddRef();
+		Base->Enqueue(Next);
+		Generic->SetReturnAddress(Future);
+	}
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsTaskGroup<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_TASKGROUP, 0, asOBJ_REF));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TASKGROUP, asBEHAVE_FACTORY, PROMISE_TASKGROUP "@ f(uint = 0)", asFUNCTION(Type::Create), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TASKGROUP, asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TASKGROUP, asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in)", asFUNCTION(Type::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in)", asFUNCTION(Type::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in, ?&in)", asFUNCTION(Type::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in, ?&in, ?&in)", asFUNCTION(Type::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SPAWN "(?&in, ?&in, ?&in, ?&in, ?&in)", asFUNCTION(Type::SpawnGeneric), asCALL_GENERIC));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ join()", asMETHOD(Type, Join), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, "uint running()", asMETHOD(Type, GetRunning), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TASKGROUP, "uint queued()", asMETHOD(Type, GetQueued), asCALL_THISCALL));
+	}
+};
+
+/* Register spawn function and task group, promise interface should be registered first */
+template <typename Executor>
+static void AsRegisterTasks(asIScriptEngine* Engine)
+{
+	AsSpawner<Executor>::Register(Engine);
+	AsTaskGroup<Executor>::Register(Engine);
+}
+#endif
+#ifndef AS_PROMISE_NO_BINDINGS
+#include <deque>
+#include <tuple>
+#include <utility>
+/*
+	Fixed size pool of threads for blocking host work, tasks
+	run in FIFO order, queued tasks are finished before pool
+	is destroyed, workers release AngelScript thread data
+*/
+class AsBlockingPool
+{
+private:
+	std::vector<std::thread> Threads;
+	std::deque<std::function<void()>> Queue;
+	std::condition_variable Notify;
+	std::mutex Mutex;
+	bool Active;
+
+public:
+	AsBlockingPool(size_t Count = std::thread::hardware_concurrency()) : Active(true)
+	{
+		Threads.reserve(Count > 0 ? Count : 1);
+		for (size_t i = 0; i < Threads.capacity(); i++)
+			Threads.emplace_back(&AsBlockingPool::Loop, this);
+	}
+	~AsBlockingPool()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Active = false;
+		Unique.unlock();
+		Notify.notify_all();
+		for (auto& Thread : Threads)
+			Thread.join();
+	}
+	/* Queue a task to be executed by one of workers */
+	void Enqueue(std::function<void()>&& Task)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		PROMISE_ASSERT(Active, "pool is shutting down");
+		Queue.push_back(std::move(Task));
+		Unique.unlock();
+		Notify.notify_one();
+	}
+	size_t GetThreads() const
+	{
+		return Threads.size();
+	}
+	size_t GetQueued()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		return Queue.size();
+	}
+
+public:
+	/* Default pool, sized by hardware concurrency */
+	static AsBlockingPool& Get()
+	{
+		static AsBlockingPool Base;
+		return Base;
+	}
+
+private:
+	void Loop()
+	{
+		while (true)
+		{
+			std::unique_lock<std::mutex> Unique(Mutex);
+			Notify.wait(Unique, [this]() { return !Active || !Queue.empty(); });
+			if (Queue.empty())
+				break;
+
+			auto Task = std::move(Queue.front());
+			Queue.pop_front();
+			Unique.unlock();
+			Task();
+		}
+		asThreadCleanup();
+	}
+};
+
+/* Signature of native callable: result type and decayed argument types */
+template <typename Function>
+struct AsCallableTraits : AsCallableTraits<decltype(&Function::operator())>
+{
+};
+template <typename R, typename... Args>
+struct AsCallableTraits<R(*)(Args...)>
+{
+	typedef R Result;
+	typedef std::tuple<typename std::decay<Args>::type...> Arguments;
+};
+template <typename R, typename... Args>
+struct AsCallableTraits<R(Args...)> : AsCallableTraits<R(*)(Args...)>
+{
+};
+template <typename Class, typename R, typename... Args>
+struct AsCallableTraits<R(Class::*)(Args...)> : AsCallableTraits<R(*)(Args...)>
+{
+};
+template <typename Class, typename R, typename... Args>
+struct AsCallableTraits<R(Class::*)(Args...) const> : AsCallableTraits<R(*)(Args...)>
+{
+};
+
+/*
+	Copy of generic call argument, primitives are stored in argument
+	slot directly, references and objects by value are stored as address
+*/
+template <typename Type, bool Primitive = std::is_arithmetic<Type>::value || std::is_enum<Type>::value>
+struct AsBindingArgument
+{
+	static_assert(!std::is_pointer<Type>::value, "handles cannot be passed to worker thread, use values");
+	static Type Get(asIScriptGeneric* Generic, asUINT Index)
+	{
+		return **(Type**)Generic->GetAddressOfArg(Index);
+	}
+};
+template <typename Type>
+struct AsBindingArgument<Type, true>
+{
+	static Type Get(asIScriptGeneric* Generic, asUINT Index)
+	{
+		return *(Type*)Generic->GetAddressOfArg(Index);
+	}
+};
+
+/*
+	Pool specific handling of tasks, by default enqueueing always succeeds and
+	work that follows a task runs in place, pools that run tasks on own stacks
+	may fail to get one and defer that work until the task stack is left (fiber pool)
+*/
+template <typename Pool>
+struct AsPoolTraits
+{
+	static bool Enqueue(Pool* Workers, std::function<void()>&& Task)
+	{
+		Workers->Enqueue(std::move(Task));
+		return true;
+	}
+	static void Complete(std::function<void()>&& Callback)
+	{
+		Callback();
+	}
+};
+
+/*
+	Script function bound to native callable that is executed by a pool,
+	arguments are copied on calling thread, returned promise is settled
+	by worker with callable result or rejected if callable throws or pool
+	could not take the task
+*/
+template <typename Executor, typename Function, typename Pool>
+class AsAsyncBinding : public std::enable_shared_from_this<AsAsyncBinding<Executor, Function, Pool>>
+{
+private:
+	typedef AsBasicPromise<Executor> Promise;
+	typedef typename AsCallableTraits<Function>::Result Result;
+	typedef typename AsCallableTraits<Function>::Arguments Arguments;
+	typedef std::make_index_sequence<std::tuple_size<Arguments>::value> Indices;
+
+private:
+	asIScriptEngine* Engine;
+	Function Callable;
+	Pool* Workers;
+	int TypeId;
+
+public:
+	AsAsyncBinding(asIScriptEngine* NewEngine, Function&& NewCallable, Pool* NewWorkers) : Engine(NewEngine), Callable(std::move(NewCallable)), Workers(NewWorkers), TypeId(asTYPEID_VOID)
+	{
+	}
+	/* Resolve value type of returned promise */
+	void Bind(asIScriptFunction* Target)
+	{
+		PROMISE_ASSERT(Target != nullptr, "function should not be null");
+		asITypeInfo* Type = Engine->GetTypeInfoById(Target->GetReturnTypeId());
+		PROMISE_ASSERT(Type != nullptr && !strncmp(Type->GetName(), PROMISE_TYPENAME, sizeof(PROMISE_TYPENAME) - 1), "async function should return a promise handle");
+		TypeId = Type != nullptr && Type->GetSubTypeCount() > 0 ? Type->GetSubTypeId() : asTYPEID_VOID;
+		PROMISE_ASSERT(std::is_void<Result>::value == (TypeId == asTYPEID_VOID), "void callable should return " PROMISE_TYPENAME PROMISE_VOIDPOSTFIX);
+		PROMISE_ASSERT(!std::is_arithmetic<Result>::value || (TypeId & asTYPEID_MASK_OBJECT) || Engine->GetSizeOfPrimitiveType(TypeId) == (int)sizeof(typename std::conditional<std::is_void<Result>::value, char, Result>::type), "callable result does not match promise type");
+	}
+
+public:
+	/* Generic calling convention entrypoint */
+	static void Call(asIScriptGeneric* Generic)
+	{
+		AsAsyncBinding* Base = (AsAsyncBinding*)Generic->GetAuxiliary();
+		Arguments Args = Unpack(Generic, Indices());
+		Promise* Future = Promise::Create();
+		Future->AddRef();
+
+		auto Self = Base->shared_from_this();
+		bool Enqueued = AsPoolTraits<Pool>::Enqueue(Base->Workers, [Self, Future, Args]() mutable
+		{
+			Self->Execute(Future, Args);
+		});
+		if (!Enqueued)
+		{
+			Future->RejectCode(PROMISE_BINDING_ERROR);
+			Future->Release();
+		}
+		Generic->SetReturnAddress(Future);
+	}
+
+private:
+	/* Callable runs on worker, promise is settled through pool traits as it resumes script */
+	void Execute(Promise* Future, Arguments& Args)
+	{
+		std::function<void()> Settle;
+		try
+		{
+			Settle = Produce(Future, Args, std::is_void<Result>());
+		}
+		catch (...)
+		{
+			Settle = [Future]() { Future->RejectCode(PROMISE_BINDING_ERROR); };
+		}
+
+		AsPoolTraits<Pool>::Complete([Future, Settle]()
+		{
+			Settle();
+			Future->Release();
+		});
+	}
+	std::function<void()> Produce(Promise* Future, Arguments& Args, std::true_type)
+	{
+		Invoke(Args, Indices());
+		return [Future]() { Future->StoreVoid(); };
+	}
+	std::function<void()> Produce(Promise* Future, Arguments& Args, std::false_type)
+	{
+		Result Value = Invoke(Args, Indices());
+		auto Self = this->shared_from_this();
+		return [Self, Future, Value]()
+		{
+			Future->Store((void*)&Value, Self->TypeId);
+			Self->Dispose(Value, std::is_pointer<Result>());
+		};
+	}
+	/* Returned handle is owned by promise after store */
+	template <typename Type>
+	void Dispose(Type* Value, std::true_type)
+	{
+		if (Value != nullptr)
+			Engine->ReleaseScriptObject((void*)Value, Engine->GetTypeInfoById(TypeId));
+	}
+	template <typename Type>
+	void Dispose(const Type&, std::false_type)
+	{
+	}
+	template <size_t... Index>
+	Result Invoke(Arguments& Args, std::index_sequence<Index...>)
+	{
+		return Callable(std::move(std::get<Index>(Args))...);
+	}
+	template <size_t... Index>
+	static Arguments Unpack(asIScriptGeneric* Generic, std::index_sequence<Index...>)
+	{
+		return Arguments(AsBindingArgument<typename std::tuple_element<Index, Arguments>::type>::Get(Generic, (asUINT)Index)...);
+	}
+	static Arguments Unpack(asIScriptGeneric*, std::index_sequence<>)
+	{
+		return Arguments();
+	}
+};
+
+/* Bindings owned by script engine, released with engine */
+class AsAsyncBindings
+{
+public:
+	static std::vector<std::shared_ptr<void>>& Get(asIScriptEngine* Engine)
+	{
+		auto* Storage = (std::vector<std::shared_ptr<void>>*)Engine->GetUserData(PROMISE_USERID + 3);
+		if (Storage != nullptr)
+			return *Storage;
+
+		Storage = new std::vector<std::shared_ptr<void>>();
+		Engine->SetUserData(Storage, PROMISE_USERID + 3);
+		Engine->SetEngineUserDataCleanupCallback(&AsAsyncBindings::Cleanup, PROMISE_USERID + 3);
+		return *Storage;
+	}
+
+private:
+	static void Cleanup(asIScriptEngine* Engine)
+	{
+		delete (std::vector<std::shared_ptr<void>>*)Engine->GetUserData(PROMISE_USERID + 3);
+	}
+};
+
+/*
+	Register a global script function that returns a promise settled by native callable
+	executed on a pool, e.g. "promise<int>@ f(const string&in)" bound to int(std::string),
+	callable result type must match promise value type, void callable is bound to promise_v,
+	pool is any type with Enqueue(std::function<void()>&&) that outlives the engine
+*/
+template <typename Executor, typename Function, typename Pool = AsBlockingPool>
+static void AsRegisterAsyncFunction(asIScriptEngine* Engine, const char* Declaration, Function&& Callable, Pool& Workers = AsBlockingPool::Get())
+{
+	typedef AsAsyncBinding<Executor, typename std::decay<Function>::type, Pool> Binding;
+	PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+	PROMISE_ASSERT(Declaration != nullptr, "declaration should not be null");
+
+	auto Base = std::make_shared<Binding>(Engine, typename std::decay<Function>::type(std::forward<Function>(Callable)), &Workers);
+	int FunctionId = Engine->RegisterGlobalFunction(Declaration, asFUNCTION(Binding::Call), asCALL_GENERIC, Base.get());
+	PROMISE_CHECK(FunctionId);
+	if (FunctionId < 0)
+		return;
+
+	Base->Bind(Engine->GetFunctionById(FunctionId));
+	AsAsyncBindings::Get(Engine).push_back(std::move(Base));
+}
+#endif
+#if PROMISE_FIBERS
+#if !defined(__unix__) && !defined(__APPLE__)
+#error "fiber module requires ucontext (posix)"
+#endif
+#include <sys/mman.h>
+#include <ucontext.h>
+#include <unistd.h>
+/*
+	Stackful coroutine on pooled stack with guard page below it, fiber runs on
+	thread that enters it and may be parked by AsAwait, it is then resumed by
+	thread that settles awaited promise, fiber is owned by pool and recycled
+	after it's task returns
+*/
+class AsFiberPool;
+class AsFiber
+{
+	friend class AsFiberPool;
+
+private:
+	std::function<void()> Task;
+	std::function<void()> Deferred;
+	std::atomic<uint32_t> Wake;
+	AsFiberPool* Owner;
+	ucontext_t Caller;
+	ucontext_t Callee;
+	AsFiber* Parent;
+	char* Stack;
+	size_t Size;
+	bool Finished;
+
+public:
+	AsFiber(const AsFiber&) = delete;
+	AsFiber& operator= (const AsFiber&) = delete;
+	/* Park current fiber until Resume is called, returns in place if it already was */
+	void Yield()
+	{
+		PROMISE_ASSERT(GetCurrent() == this, "only running fiber can yield");
+		if (Wake.load() != Resumed)
+			PROMISE_CHECK(swapcontext(&Callee, &Caller));
+		Wake = Running;
+	}
+	/* Continue parked fiber on calling thread, may be called before fiber is parked */
+	void Resume()
+	{
+		if (Wake.exchange(Resumed) == Parked)
+			Enter();
+	}
+
+public:
+	/* Get fiber running on calling thread if any */
+	static AsFiber*& GetCurrent()
+	{
+		static thread_local AsFiber* Current = nullptr;
+		return Current;
+	}
+	/*
+		Run callback after task of current fiber returns, on stack of thread that
+		entered it and with current fiber restored, so that resumed script does not
+		run on fiber stack, runs in place outside of fiber
+	*/
+	static void Defer(std::function<void()>&& Callback)
+	{
+		AsFiber* Self = GetCurrent();
+		if (!Self)
+			return Callback();
+
+		PROMISE_ASSERT(!Self->Deferred, "fiber task may defer only one callback");
+		Self->Deferred = std::move(Callback);
+	}
+
+private:
+	/* Stack is null if it could not be mapped, guard page splits mapping in two so vm.max_map_count may be hit */
+	AsFiber(size_t StackSize) : Wake(Running), Owner(nullptr), Parent(nullptr), Finished(true)
+	{
+		size_t Page = (size_t)sysconf(_SC_PAGESIZE);
+		Size = (StackSize + Page - 1) / Page * Page + Page;
+		Stack = (char*)mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+		if (Stack == MAP_FAILED)
+			Stack = nullptr;
+		else if (mprotect(Stack, Page, PROT_NONE) != 0)
+		{
+			munmap(Stack, Size);
+			Stack = nullptr;
+		}
+	}
+	~AsFiber()
+	{
+		if (Stack != nullptr)
+			munmap(Stack, Size);
+	}
+	/* Switch into fiber until it yields or returns, fiber that returned goes back to pool */
+	void Enter()
+	{
+		for (;;)
+		{
+			Parent = GetCurrent();
+			GetCurrent() = this;
+			PROMISE_CHECK(swapcontext(&Caller, &Callee));
+			GetCurrent() = Parent;
+			if (Finished)
+			{
+				std::function<void()> Callback = std::move(Deferred);
+				Deferred = nullptr;
+				Recycle();
+				if (Callback)
+					Callback();
+				return;
+			}
+
+			/* Fiber is switched out at this point, settle may resume it from now on */
+			if (Wake.exchange(Parked) != Resumed)
+				return;
+		}
+	}
+	/* Prepare context of fresh task on top of stack */
+	void Prepare(std::function<void()>&& NewTask)
+	{
+		Task = std::move(NewTask);
+		Finished = false;
+		Wake = Running;
+		PROMISE_CHECK(getcontext(&Callee));
+		Callee.uc_stack.ss_sp = Stack;
+		Callee.uc_stack.ss_size = Size;
+		Callee.uc_link = nullptr;
+		makecontext(&Callee, &AsFiber::Entry, 0);
+	}
+	inline void Recycle();
+
+private:
+	static void Entry()
+	{
+		AsFiber* Self = GetCurrent();
+		/* Exceptions cannot unwind through context switch, tasks should catch their own */
+		try
+		{
+			Self->Task();
+		}
+		catch (...)
+		{
+			PROMISE_ASSERT(false, "fiber task should not throw");
+		}
+		Self->Task = nullptr;
+		Self->Finished = true;
+		swapcontext(&Self->Callee, &Self->Caller);
+	}
+
+private:
+	enum
+	{
+		Running,
+		Parked,
+		Resumed
+	};
+};
+
+/*
+	Pool of fibers, tasks run immediately on calling thread but on a fiber stack so
+	that they may await promises without blocking, it satisfies pool requirements of
+	AsRegisterAsyncFunction so native callables bound to it may use AsAwait
+*/
+class AsFiberPool
+{
+private:
+	std::vector<AsFiber*> Fibers;
+	std::atomic<uint64_t> Failures;
+	std::mutex Mutex;
+	size_t StackSize;
+	size_t Capacity;
+
+public:
+	AsFiberPool(size_t NewStackSize = PROMISE_FIBER_STACK, size_t NewCapacity = PROMISE_FIBER_POOL) : Failures(0), StackSize(NewStackSize), Capacity(NewCapacity)
+	{
+	}
+	AsFiberPool(const AsFiberPool&) = delete;
+	AsFiberPool& operator= (const AsFiberPool&) = delete;
+	~AsFiberPool()
+	{
+		for (auto* Next : Fibers)
+		{
+			Next->~AsFiber();
+			asFreeMem((void*)Next);
+		}
+	}
+	/* Run task on a fiber until it returns or awaits a pending promise, returns false and drops the task if no stack could be mapped */
+	bool Enqueue(std::function<void()>&& Task)
+	{
+		AsFiber* Next = Acquire();
+		if (!Next)
+			return false;
+
+		Next->Prepare(std::move(Task));
+		Next->Enter();
+		return true;
+	}
+	/* Get count of idle fibers */
+	size_t GetIdle()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		return Fibers.size();
+	}
+	/* Get count of tasks dropped because fiber stack could not be mapped */
+	uint64_t GetFailures()
+	{
+		return Failures.load(std::memory_order_relaxed);
+	}
+
+public:
+	static AsFiberPool& Get()
+	{
+		static AsFiberPool Base;
+		return Base;
+	}
+
+private:
+	AsFiber* Acquire()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (!Fibers.empty())
+		{
+			AsFiber* Next = Fibers.back();
+			Fibers.pop_back();
+			return Next;
+		}
+
+		Unique.unlock();
+		AsFiber* Next = new(asAllocMem(sizeof(AsFiber))) AsFiber(StackSize);
+		if (!Next->Stack)
+		{
+			Next->~AsFiber();
+			asFreeMem((void*)Next);
+			Failures.fetch_add(1, std::memory_order_relaxed);
+			return nullptr;
+		}
+
+		Next->Owner = this;
+		return Next;
+	}
+	void Push(AsFiber* Next)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Fibers.size() < Capacity)
+			return Fibers.push_back(Next);
+
+		Unique.unlock();
+		Next->~AsFiber();
+		asFreeMem((void*)Next);
+	}
+
+	friend class AsFiber;
+};
+
+/* Give fiber back to it's pool, called on thread that saw it return */
+inline void AsFiber::Recycle()
+{
+	Owner->Push(this);
+}
+
+#ifndef AS_PROMISE_NO_BINDINGS
+/* Bindings are rejected if fiber is not available and settle their promises only after fiber was left */
+template <>
+struct AsPoolTraits<AsFiberPool>
+{
+	static bool Enqueue(AsFiberPool* Workers, std::function<void()>&& Task)
+	{
+		return Workers->Enqueue(std::move(Task));
+	}
+	static void Complete(std::function<void()>&& Callback)
+	{
+		AsFiber::Defer(std::move(Callback));
+	}
+};
+#endif
+
+/*
+	Await a promise inside of native code, running fiber is parked until promise
+	is settled and then continues on settling thread, outside of fiber this falls
+	back to blocking WaitIf, returns settled promise
+*/
+template <typename Promise>
+static Promise* AsAwait(Promise* Target)
+{
+	PROMISE_ASSERT(Target != nullptr, "promise should not be null");
+	AsFiber* Self = AsFiber::GetCurrent();
+	if (Self == nullptr)
+	{
+		Target->WaitIf();
+		return Target;
+	}
+
+	Target->Attach([Self](Promise*) { Self->Resume(); });
+	Self->Yield();
+	return Target;
+}
+#endif
+#if PROMISE_PARALLEL
+#ifdef AS_PROMISE_NO_BINDINGS
+#error "parallel module requires blocking pool of bindings section"
+#endif
+#ifndef SCRIPTARRAY_H
+#error "parallel module requires scriptarray add-on to be included before promise header"
+#endif
+/*
+	Data-parallel loops for scripts, range is split into chunks executed on
+	pooled contexts by pool workers, results are written into preallocated
+	slots without locking and one promise is settled by the last chunk,
+	callbacks run concurrently so they should not suspend or share mutable
+	script state
+*/
+template <typename Executor, typename Pool = AsBlockingPool>
+class AsParallel
+{
+private:
+	typedef AsBasicPromise<Executor> Promise;
+	struct Job
+	{
+		std::atomic<uint32_t> Remaining;
+		std::atomic<bool> Failed;
+		asIScriptEngine* Engine;
+		asIScriptFunction* Callback;
+		CScriptArray* Input;
+		CScriptArray* Output;
+		Promise* Future;
+	};
+
+public:
+	/* parallel_for(begin, end, callback, chunk) */
+	static void ForGeneric(asIScriptGeneric* Generic)
+	{
+		uint32_t Begin = (uint32_t)Generic->GetArgDWord(0);
+		uint32_t End = (uint32_t)Generic->GetArgDWord(1);
+		asIScriptFunction* Callback = (asIScriptFunction*)Generic->GetArgAddress(2);
+		uint32_t Chunk = (uint32_t)Generic->GetArgDWord(3);
+		Promise* Future = Promise::Create();
+		Future->AddRef();
+		if (!Callback || End <= Begin)
+		{
+			if (!Callback)
+				Future->RejectCode(PROMISE_PARALLEL_ERROR);
+			else
+				Future->StoreVoid();
+			Future->Release();
+		}
+		else
+		{
+			Callback->AddRef();
+			Launch(Create(Generic->GetEngine(), Callback, nullptr, nullptr, Future), Begin, End, Chunk, (Pool*)Generic->GetAuxiliary());
+		}
+		Generic->SetReturnAddress(Future);
+	}
+	/* array<T>.parallel_map(callback, chunk) */
+	static void MapGeneric(asIScriptGeneric* Generic)
+	{
+		CScriptArray* Input = (CScriptArray*)Generic->GetObject();
+		asIScriptFunction* Callback = (asIScriptFunction*)Generic->GetArgAddress(0);
+		uint32_t Chunk = (uint32_t)Generic->GetArgDWord(1);
+		Promise* Future = Promise::Create();
+		CScriptArray* Output = CScriptArray::Create(Input->GetArrayObjectType(), Input->GetSize());
+		Future->AddRef();
+		if (!Callback || Input->IsEmpty())
+		{
+			if (!Callback)
+				Future->RejectCode(PROMISE_PARALLEL_ERROR);
+			else
+				Future->Store((void*)&Output, Output->GetArrayTypeId() | asTYPEID_OBJHANDLE);
+			Output->Release();
+			Future->Release();
+		}
+		else
+		{
+			Input->AddRef();
+			Callback->AddRef();
+			Launch(Create(Generic->GetEngine(), Callback, Input, Output, Future), 0, Input->GetSize(), Chunk, (Pool*)Generic->GetAuxiliary());
+		}
+		Generic->SetReturnAddress(Future);
+	}
+	/* Register functions bound to pool, pool should outlive the engine */
+	static void Register(asIScriptEngine* Engine, Pool* Workers)
+	{
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_ASSERT(Workers != nullptr, "pool should not be null");
+		PROMISE_CHECK(Engine->RegisterFuncdef("void " PROMISE_PARALLELFOR "_callback(uint)"));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_PARALLELFOR "(uint, uint, " PROMISE_PARALLELFOR "_callback@, uint = 0)", asFUNCTION(ForGeneric), asCALL_GENERIC, (void*)Workers));
+		PROMISE_CHECK(Engine->RegisterFuncdef("T array<T>::" PROMISE_PARALLELMAP "_callback(const T&in)"));
+		PROMISE_CHECK(Engine->RegisterObjectMethod("array<T>", PROMISE_TYPENAME "<array<T>@>@ " PROMISE_PARALLELMAP "(" PROMISE_PARALLELMAP "_callback@, uint = 0)", asFUNCTION(MapGeneric), asCALL_GENERIC, (void*)Workers));
+	}
+
+private:
+	static Job* Create(asIScriptEngine* Engine, asIScriptFunction* Callback, CScriptArray* Input, CScriptArray* Output, Promise* Future)
+	{
+		Job* Next = new(asAllocMem(sizeof(Job))) Job();
+		Next->Failed = false;
+		Next->Engine = Engine;
+		Next->Callback = Callback;
+		Next->Input = Input;
+		Next->Output = Output;
+		Next->Future = Future;
+		return Next;
+	}
+	/* Split range into chunks, default chunk gives each worker about four of them */
+	static void Launch(Job* Next, uint32_t Begin, uint32_t End, uint32_t Chunk, Pool* Workers)
+	{
+		uint32_t Size = End - Begin;
+		if (!Chunk)
+		{
+			uint32_t Parts = (uint32_t)std::max<size_t>(Workers->GetThreads(), 1) * 4;
+			Chunk = std::max<uint32_t>(1, (Size + Parts - 1) / Parts);
+		}
+
+		Next->Remaining = (Size + Chunk - 1) / Chunk;
+		for (uint32_t From = Begin; From < End; From += std::min(Chunk, End - From))
+		{
+			uint32_t To = From + std::min(Chunk, End - From);
+			Workers->Enqueue([Next, From, To]() { Execute(Next, From, To); });
+		}
+	}
+	static void Execute(Job* Next, uint32_t From, uint32_t To)
+	{
+		asIScriptContext* Context = Next->Engine->RequestContext();
+		for (uint32_t i = From; i < To && !Next->Failed; i++)
+		{
+			bool Success = Context->Prepare(Next->Callback) >= 0;
+			if (Success)
+			{
+				if (Next->Input != nullptr)
+					Success = Context->SetArgAddress(0, Next->Input->At(i)) >= 0;
+				else
+					Success = Context->SetArgDWord(0, (asDWORD)i) >= 0;
+			}
+
+			int Status = Success ? Context->Execute() : asEXECUTION_ERROR;
+			if (Status == asEXECUTION_FINISHED)
+			{
+				if (Next->Output != nullptr)
+					Next->Output->SetValue(i, Context->GetAddressOfReturnValue());
+				continue;
+			}
+
+			if (Status == asEXECUTION_SUSPENDED)
+				Context->Abort();
+			Next->Failed = true;
+		}
+
+		Context->Unprepare();
+		Next->Engine->ReturnContext(Context);
+		if (!--Next->Remaining)
+			Finish(Next);
+	}
+	static void Finish(Job* Next)
+	{
+		Promise* Future = Next->Future;
+		if (Next->Failed)
+			Future->RejectCode(PROMISE_PARALLEL_ERROR);
+		else if (Next->Output != nullptr)
+			Future->Store((void*)&Next->Output, Next->Output->GetArrayTypeId() | asTYPEID_OBJHANDLE);
+		else
+			Future->StoreVoid();
+
+		if (Next->Input != nullptr)
+			Next->Input->Release();
+		if (Next->Output != nullptr)
+			Next->Output->Release();
+		Next->Callback->Release();
+		Next->~Job();
+		asFreeMem((void*)Next);
+		Future->Release();
+	}
+};
+
+/* Register parallel_for and array<T>.parallel_map, promise interface and array<T> should be registered first */
+template <typename Executor, typename Pool = AsBlockingPool>
+static void AsRegisterParallel(asIScriptEngine* Engine, Pool& Workers = AsBlockingPool::Get())
+{
+	AsParallel<Executor, Pool>::Register(Engine, &Workers);
+}
+#endif
+#if PROMISE_FILES
+#ifndef SCRIPTARRAY_H
+#error "async file module requires scriptarray add-on to be included before promise header"
+#endif
+#ifdef AS_PROMISE_NO_BINDINGS
+#error "async file module requires blocking pool (AS_PROMISE_NO_BINDINGS is defined)"
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <string>
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#define PROMISE_URING
+#endif
+#endif
+/*
+	Queue of positional file reads and writes, uses io_uring when kernel
+	supports it and blocking pool otherwise, completions are reaped in
+	batches by one thread and every batch is handed to the pool as one
+	task, callbacks of a batch are called in completion order
+*/
+class AsFileQueue
+{
+public:
+	/* Transferred bytes or negative errno */
+	typedef std::function<void(int64_t)> Completion;
+
+private:
+	struct Request
+	{
+		Completion Callback;
+		struct iovec Buffer;
+	};
+
+private:
+	AsBlockingPool* Fallback;
+#ifdef PROMISE_URING
+	struct
+	{
+		io_uring_sqe* Sqes = nullptr;
+		io_uring_cqe* Cqes = nullptr;
+		uint32_t* SqHead = nullptr;
+		uint32_t* SqTail = nullptr;
+		uint32_t* SqArray = nullptr;
+		uint32_t* CqHead = nullptr;
+		uint32_t* CqTail = nullptr;
+		uint32_t SqMask = 0;
+		uint32_t CqMask = 0;
+		uint32_t Capacity = 0;
+		void* SqRing = MAP_FAILED;
+		void* CqRing = MAP_FAILED;
+		size_t SqSize = 0;
+		size_t CqSize = 0;
+		size_t SqesSize = 0;
+		int Fd = -1;
+	} Ring;
+	std::atomic<uint32_t> InFlight;
+	std::mutex Submission;
+	std::thread Reaper;
+#endif
+
+public:
+	AsFileQueue(uint32_t Entries = PROMISE_FILE_ENTRIES, AsBlockingPool* Pool = &AsBlockingPool::Get()) : Fallback(Pool)
+	{
+		PROMISE_ASSERT(Fallback != nullptr, "fallback pool should not be null");
+#ifdef PROMISE_URING
+		InFlight = 0;
+		if (Setup(Entries))
+			Reaper = std::thread(&AsFileQueue::Reap, this);
+#endif
+	}
+	~AsFileQueue()
+	{
+#ifdef PROMISE_URING
+		if (Reaper.joinable())
+		{
+			/* Request with no user data stops the reaper after all previous completions */
+			while (!Submit(IORING_OP_NOP, -1, nullptr, 0, 0))
+				std::this_thread::yield();
+			Reaper.join();
+		}
+		Teardown();
+#endif
+	}
+	/* Read up to size bytes at offset into buffer, buffer must live until completion */
+	void Read(int Fd, void* Buffer, size_t Size, uint64_t Offset, Completion&& Callback)
+	{
+		Request* Next = new Request();
+		Next->Callback = std::move(Callback);
+		Next->Buffer.iov_base = Buffer;
+		Next->Buffer.iov_len = Size;
+#ifdef PROMISE_URING
+		if (Submit(IORING_OP_READV, Fd, Next, Offset, 0))
+			return;
+#endif
+		Fallback->Enqueue([Next, Fd, Offset]()
+		{
+			ssize_t Result = pread(Fd, Next->Buffer.iov_base, Next->Buffer.iov_len, (off_t)Offset);
+			Complete(Next, Result < 0 ? -(int64_t)errno : (int64_t)Result);
+		});
+	}
+	/* Write up to size bytes at offset from buffer, buffer must live until completion */
+	void Write(int Fd, const void* Buffer, size_t Size, uint64_t Offset, Completion&& Callback)
+	{
+		Request* Next = new Request();
+		Next->Callback = std::move(Callback);
+		Next->Buffer.iov_base = (void*)Buffer;
+		Next->Buffer.iov_len = Size;
+#ifdef PROMISE_URING
+		if (Submit(IORING_OP_WRITEV, Fd, Next, Offset, 0))
+			return;
+#endif
+		Fallback->Enqueue([Next, Fd, Offset]()
+		{
+			ssize_t Result = pwrite(Fd, Next->Buffer.iov_base, Next->Buffer.iov_len, (off_t)Offset);
+			Complete(Next, Result < 0 ? -(int64_t)errno : (int64_t)Result);
+		});
+	}
+	/* Check if requests are executed by kernel instead of pool */
+	bool IsAccelerated() const
+	{
+#ifdef PROMISE_URING
+		return Ring.Fd >= 0;
+#else
+		return false;
+#endif
+	}
+
+public:
+	/* Default queue, backed by default blocking pool */
+	static AsFileQueue& Get()
+	{
+		static AsFileQueue Base;
+		return Base;
+	}
+
+private:
+	static void Complete(Request* Next, int64_t Result)
+	{
+		Completion Callback = std::move(Next->Callback);
+		delete Next;
+		Callback(Result);
+	}
+#ifdef PROMISE_URING
+	bool Setup(uint32_t Entries)
+	{
+		io_uring_params Params;
+		memset(&Params, 0, sizeof(Params));
+		Ring.Fd = (int)syscall(__NR_io_uring_setup, Entries, &Params);
+		if (Ring.Fd < 0)
+			return false;
+
+		Ring.SqSize = Params.sq_off.array + Params.sq_entries * sizeof(uint32_t);
+		Ring.CqSize = Params.cq_off.cqes + Params.cq_entries * sizeof(io_uring_cqe);
+		Ring.SqesSize = Params.sq_entries * sizeof(io_uring_sqe);
+		if (Params.features & IORING_FEAT_SINGLE_MMAP)
+			Ring.SqSize = Ring.CqSize = (Ring.SqSize > Ring.CqSize ? Ring.SqSize : Ring.CqSize);
+
+		Ring.SqRing = mmap(nullptr, Ring.SqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring.Fd, IORING_OFF_SQ_RING);
+		if (Ring.SqRing != MAP_FAILED && (Params.features & IORING_FEAT_SINGLE_MMAP))
+			Ring.CqRing = Ring.SqRing;
+		else if (Ring.SqRing != MAP_FAILED)
+			Ring.CqRing = mmap(nullptr, Ring.CqSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring.Fd, IORING_OFF_CQ_RING);
+
+		void* Sqes = mmap(nullptr, Ring.SqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, Ring.Fd, IORING_OFF_SQES);
+		if (Ring.SqRing == MAP_FAILED || Ring.CqRing == MAP_FAILED || Sqes == MAP_FAILED)
+		{
+			if (Sqes != MAP_FAILED)
+				munmap(Sqes, Ring.SqesSize);
+			Teardown();
+			return false;
+		}
+
+		char* Sq = (char*)Ring.SqRing, *Cq = (char*)Ring.CqRing;
+		Ring.Sqes = (io_uring_sqe*)Sqes;
+		Ring.Cqes = (io_uring_cqe*)(Cq + Params.cq_off.cqes);
+		Ring.SqHead = (uint32_t*)(Sq + Params.sq_off.head);
+		Ring.SqTail = (uint32_t*)(Sq + Params.sq_off.tail);
+		Ring.SqArray = (uint32_t*)(Sq + Params.sq_off.array);
+		Ring.CqHead = (uint32_t*)(Cq + Params.cq_off.head);
+		Ring.CqTail = (uint32_t*)(Cq + Params.cq_off.tail);
+		Ring.SqMask = *(uint32_t*)(Sq + Params.sq_off.ring_mask);
+		Ring.CqMask = *(uint32_t*)(Cq + Params.cq_off.ring_mask);
+		Ring.Capacity = Params.cq_entries;
+		return true;
+	}
+	void Teardown()
+	{
+		if (Ring.Sqes != nullptr)
+			munmap(Ring.Sqes, Ring.SqesSize);
+		if (Ring.CqRing != MAP_FAILED && Ring.CqRing != Ring.SqRing)
+			munmap(Ring.CqRing, Ring.CqSize);
+		if (Ring.SqRing != MAP_FAILED)
+			munmap(Ring.SqRing, Ring.SqSize);
+		if (Ring.Fd >= 0)
+			close(Ring.Fd);
+		Ring.Sqes = nullptr;
+		Ring.SqRing = Ring.CqRing = MAP_FAILED;
+		Ring.Fd = -1;
+	}
+	/* Push one request into submission queue, fails if ring is unavailable or completion queue may overflow */
+	bool Submit(uint8_t Opcode, int Fd, Request* Next, uint64_t Offset, uint32_t Flags)
+	{
+		if (Ring.Fd < 0)
+			return false;
+
+		std::unique_lock<std::mutex> Unique(Submission);
+		uint32_t Tail = *Ring.SqTail;
+		uint32_t Head = __atomic_load_n(Ring.SqHead, __ATOMIC_ACQUIRE);
+		if (Tail - Head > Ring.SqMask || InFlight.load(std::memory_order_relaxed) >= Ring.Capacity)
+			return false;
+
+		uint32_t Index = Tail & Ring.SqMask;
+		io_uring_sqe* Entry = &Ring.Sqes[Index];
+		memset(Entry, 0, sizeof(*Entry));
+		Entry->opcode = Opcode;
+		Entry->fd = Fd;
+		Entry->off = Offset;
+		Entry->rw_flags = (__kernel_rwf_t)Flags;
+		if (Next != nullptr)
+		{
+			Entry->addr = (uint64_t)(uintptr_t)&Next->Buffer;
+			Entry->len = 1;
+		}
+		Entry->user_data = (uint64_t)(uintptr_t)Next;
+		Ring.SqArray[Index] = Index;
+		__atomic_store_n(Ring.SqTail, Tail + 1, __ATOMIC_RELEASE);
+		InFlight.fetch_add(1, std::memory_order_relaxed);
+
+		int Status;
+		do
+		{
+			Status = (int)syscall(__NR_io_uring_enter, Ring.Fd, 1, 0, 0, nullptr, 0);
+		} while (Status < 0 && (errno == EINTR || errno == EAGAIN));
+		PROMISE_ASSERT(Status >= 0, "io_uring submission failed");
+		return true;
+	}
+	/* Wait for completions, reap all available ones at once then dispatch them */
+	void Reap()
+	{
+		std::vector<std::pair<Request*, int64_t>> Batch;
+		bool Active = true;
+		while (Active)
+		{
+			int Status = (int)syscall(__NR_io_uring_enter, Ring.Fd, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+			if (Status < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY)
+				break;
+
+			uint32_t Head = *Ring.CqHead;
+			uint32_t Tail = __atomic_load_n(Ring.CqTail, __ATOMIC_ACQUIRE);
+			for (; Head != Tail; Head++)
+			{
+				io_uring_cqe* Entry = &Ring.Cqes[Head & Ring.CqMask];
+				Request* Next = (Request*)(uintptr_t)Entry->user_data;
+				if (Next != nullptr)
+					Batch.emplace_back(Next, (int64_t)Entry->res);
+				else
+					Active = false;
+			}
+			__atomic_store_n(Ring.CqHead, Head, __ATOMIC_RELEASE);
+			InFlight.fetch_sub((uint32_t)Batch.size() + (Active ? 0 : 1), std::memory_order_relaxed);
+			if (Batch.empty())
+				continue;
+
+			/* Resumption of scripts should not hold the reaper */
+			auto Dispatch = std::make_shared<std::vector<std::pair<Request*, int64_t>>>(std::move(Batch));
+			Fallback->Enqueue([Dispatch]()
+			{
+				for (auto& Item : *Dispatch)
+					Complete(Item.first, Item.second);
+			});
+			Batch.clear();
+		}
+		asThreadCleanup();
+	}
+#endif
+};
+
+/*
+	Script file handle, descriptor is closed when last reference is
+	released, pending requests hold a reference to their file
+*/
+template <typename Executor>
+class AsAsyncFile
+{
+private:
+	typedef AsBasicPromise<Executor> Promise;
+
+private:
+	std::atomic<uint32_t> RefCount;
+	asIScriptEngine* Engine;
+	int Fd;
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		PROMISE_ASSERT(RefCount > 0, "file is already released");
+		if (!--RefCount)
+		{
+			this->~AsAsyncFile();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		++RefCount;
+	}
+	/* Read up to size bytes at offset, array is shrunk to transferred bytes */
+	Promise* ReadAt(uint64_t Offset, uint32_t Size)
+	{
+		Promise* Future = Promise::Create();
+		CScriptArray* Data = AsCreateByteArray(Engine, Size);
+		Future->AddRef();
+		AddRef();
+		AsFileQueue::Get().Read(Fd, Data->GetBuffer(), Size, Offset, [this, Future, Data](int64_t Result)
+		{
+			if (Result >= 0)
+				Data->Resize((asUINT)Result);
+			Settle(Future, Data, Result);
+			Release();
+		});
+		return Future;
+	}
+	/* Write copy of array at offset, promise holds count of transferred bytes */
+	Promise* WriteAt(uint64_t Offset, const CScriptArray& Data)
+	{
+		Promise* Future = Promise::Create();
+		auto Source = AsCopyByteArray(Data);
+		Future->AddRef();
+		AddRef();
+		AsFileQueue::Get().Write(Fd, Source->data(), Source->size(), Offset, [this, Future, Source](int64_t Result)
+		{
+			if (Result >= 0)
+			{
+				uint32_t Written = (uint32_t)Result;
+				Future->Store(&Written, asTYPEID_UINT32);
+			}
+			else
+				Future->RejectCode((int)-Result);
+			Future->Release();
+			Release();
+		});
+		return Future;
+	}
+	/* Current size of file, zero on failure */
+	uint64_t GetSize()
+	{
+		struct stat Info;
+		return fstat(Fd, &Info) == 0 ? (uint64_t)Info.st_size : 0;
+	}
+
+private:
+	AsAsyncFile(asIScriptEngine* NewEngine, int NewFd) noexcept : RefCount(1), Engine(NewEngine), Fd(NewFd)
+	{
+	}
+	~AsAsyncFile()
+	{
+		close(Fd);
+	}
+
+public:
+	/* Open file by path and mode as in fopen, returns null on failure, blocking */
+	static AsAsyncFile* Open(const std::string& Path, const std::string& Mode)
+	{
+		int Flags = 0;
+		if (Mode == "r" || Mode == "rb")
+			Flags = O_RDONLY;
+		else if (Mode == "w" || Mode == "wb")
+			Flags = O_WRONLY | O_CREAT | O_TRUNC;
+		else if (Mode == "a" || Mode == "ab")
+			Flags = O_WRONLY | O_CREAT | O_APPEND;
+		else if (Mode == "r+" || Mode == "rb+" || Mode == "r+b")
+			Flags = O_RDWR;
+		else if (Mode == "w+" || Mode == "wb+" || Mode == "w+b")
+			Flags = O_RDWR | O_CREAT | O_TRUNC;
+		else if (Mode == "a+" || Mode == "ab+" || Mode == "a+b")
+			Flags = O_RDWR | O_CREAT | O_APPEND;
+		else
+			return nullptr;
+
+		int Fd = open(Path.c_str(), Flags | O_CLOEXEC, 0644);
+		if (Fd < 0)
+			return nullptr;
+
+		asIScriptContext* Context = asGetActiveContext();
+		PROMISE_ASSERT(Context != nullptr, "file should be opened from script context");
+		return new(asAllocMem(sizeof(AsAsyncFile))) AsAsyncFile(Context->GetEngine(), Fd);
+	}
+	/*
+		Read whole file, reads are chained until end of file, size of regular
+		file is used as is, files that report no size (e.g. /proc) and other
+		descriptors are read into a buffer that grows until end of file
+	*/
+	static Promise* ReadFile(const std::string& Path)
+	{
+		Promise* Future = Promise::Create();
+		AsAsyncFile* File = Open(Path, "r");
+		if (!File)
+		{
+			Future->RejectCode(errno);
+			return Future;
+		}
+
+		struct stat Info;
+		bool Sized = fstat(File->Fd, &Info) == 0 && S_ISREG(Info.st_mode) && Info.st_size > 0;
+		if (Sized && (uint64_t)Info.st_size > (uint64_t)std::numeric_limits<asUINT>::max())
+		{
+			File->Release();
+			Future->RejectCode(EFBIG);
+			return Future;
+		}
+
+		CScriptArray* Data = AsCreateByteArray(File->Engine, Sized ? (asUINT)Info.st_size : PROMISE_FILE_CHUNK);
+		Future->AddRef();
+		File->ReadChain(Future, Data, 0, !Sized);
+		return Future;
+	}
+	/* Replace file contents with copy of array */
+	static Promise* WriteFile(const std::string& Path, const CScriptArray& Data)
+	{
+		Promise* Future = Promise::Create();
+		AsAsyncFile* File = Open(Path, "w");
+		if (!File)
+		{
+			Future->RejectCode(errno);
+			return Future;
+		}
+
+		Future->AddRef();
+		File->WriteChain(Future, AsCopyByteArray(Data), 0);
+		return Future;
+	}
+	/* Register file type and functions, promise interface and array<T> should be registered first */
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsAsyncFile<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_FILE, 0, asOBJ_REF));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_FILE, asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_FILE, asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_FILE, PROMISE_TYPENAME "<array<uint8>@>@ read_at(uint64, uint)", asMETHOD(Type, ReadAt), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_FILE, PROMISE_TYPENAME "<uint>@ write_at(uint64, const array<uint8>&in)", asMETHOD(Type, WriteAt), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_FILE, "uint64 size()", asMETHOD(Type, GetSize), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_FILE "@ open(const string&in, const string&in)", asFUNCTION(Type::Open), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME "<array<uint8>@>@ read_file(const string&in)", asFUNCTION(Type::ReadFile), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ write_file(const string&in, const array<uint8>&in)", asFUNCTION(Type::WriteFile), asCALL_CDECL));
+	}
+
+private:
+	/* Continue reading into array at offset, growing array doubles when full, consumes file reference */
+	void ReadChain(Promise* Future, CScriptArray* Data, uint64_t Offset, bool Growing)
+	{
+		if (Offset >= Data->GetSize())
+		{
+			if (!Growing || Data->GetSize() > std::numeric_limits<asUINT>::max() / 2)
+			{
+				Settle(Future, Data, Growing ? -(int64_t)EFBIG : (int64_t)Offset);
+				return Release();
+			}
+			Data->Resize(Data->GetSize() * 2);
+		}
+
+		AsFileQueue::Get().Read(Fd, (char*)Data->GetBuffer() + Offset, (size_t)(Data->GetSize() - Offset), Offset, [this, Future, Data, Offset, Growing](int64_t Result)
+		{
+			if (Result > 0)
+				return ReadChain(Future, Data, Offset + (uint64_t)Result, Growing);
+
+			/* End of file or file was truncated while reading */
+			if (Result == 0)
+				Data->Resize((asUINT)Offset);
+			Settle(Future, Data, Result < 0 ? Result : (int64_t)Offset);
+			Release();
+		});
+	}
+	/* Continue writing buffer at offset, consumes file reference */
+	void WriteChain(Promise* Future, const std::shared_ptr<std::vector<uint8_t>>& Source, uint64_t Offset)
+	{
+		if (Offset >= Source->size())
+		{
+			Future->StoreVoid();
+			Future->Release();
+			return Release();
+		}
+
+		AsFileQueue::Get().Write(Fd, Source->data() + Offset, (size_t)(Source->size() - Offset), Offset, [this, Future, Source, Offset](int64_t Result)
+		{
+			if (Result > 0)
+				return WriteChain(Future, Source, Offset + (uint64_t)Result);
+
+			Future->RejectCode(Result < 0 ? (int)-Result : EIO);
+			Future->Release();
+			Release();
+		});
+	}
+	/* Settle read promise with array or errno, consumes array and promise references */
+	static void Settle(Promise* Future, CScriptArray* Data, int64_t Result)
+	{
+		if (Result >= 0)
+		{
+			int TypeId = Data->GetArrayTypeId() | asTYPEID_OBJHANDLE;
+			Future->Store((void*)&Data, TypeId);
+		}
+		else
+			Future->RejectCode((int)-Result);
+		Data->Release();
+		Future->Release();
+	}
+};
+
+/* Register async file module, promise interface and array<T> should be registered first */
+template <typename Executor>
+static void AsRegisterFiles(asIScriptEngine* Engine)
+{
+	AsAsyncFile<Executor>::Register(Engine);
+}
+#endif
+#if PROMISE_SOCKETS || PROMISE_PROCESSES
+#ifndef __linux__
+#error "socket and process reactor requires linux (epoll)"
+#endif
+#ifndef SCRIPTARRAY_H
+#error "socket and process modules require scriptarray add-on to be included before promise header"
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <chrono>
+#include <deque>
+#include <queue>
+#include <string>
+#include <unordered_set>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+/* Descriptor registered in reactor, reactor holds one reference while registered */
+class AsReactorHandle
+{
+public:
+	virtual ~AsReactorHandle() = default;
+	virtual void OnEvent(uint32_t Events) = 0;
+	/* Detach and close descriptor, pending operations are cancelled */
+	virtual void Close() = 0;
+	virtual void Release() = 0;
+};
+
+/*
+	Event loop on epoll, one wait handles edge-triggered descriptor readiness,
+	timers and cross-thread wakeups (eventfd), must be dispatched by one thread
+*/
+class AsReactor
+{
+private:
+	struct Timer
+	{
+		uint64_t Deadline;
+		uint64_t Sequence;
+		std::function<void()> Callback;
+
+		bool operator> (const Timer& Other) const
+		{
+			return Deadline != Other.Deadline ? Deadline > Other.Deadline : Sequence > Other.Sequence;
+		}
+	};
+
+private:
+	std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> Timers;
+	std::vector<std::function<void()>> Posted;
+	std::unordered_set<AsReactorHandle*> Handles;
+	std::mutex Mutex;
+	uint64_t Sequence;
+	int Fd;
+	int Wakeup;
+
+public:
+	AsReactor() : Sequence(0)
+	{
+		Fd = epoll_create1(EPOLL_CLOEXEC);
+		Wakeup = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+		PROMISE_ASSERT(Fd >= 0 && Wakeup >= 0, "cannot create epoll or eventfd descriptor");
+
+		epoll_event Event;
+		Event.events = EPOLLIN | EPOLLET;
+		Event.data.ptr = nullptr;
+		PROMISE_CHECK(epoll_ctl(Fd, EPOLL_CTL_ADD, Wakeup, &Event));
+	}
+	AsReactor(const AsReactor&) = delete;
+	AsReactor& operator= (const AsReactor&) = delete;
+	~AsReactor()
+	{
+		/* Handles that are still attached are closed so that they never reach this reactor again */
+		std::unique_lock<std::mutex> Unique(Mutex);
+		std::vector<AsReactorHandle*> Attached(Handles.begin(), Handles.end());
+		Unique.unlock();
+		for (auto* Handle : Attached)
+			Handle->Close();
+
+		while (Execute() > 0);
+		close(Wakeup);
+		close(Fd);
+	}
+	/* Register descriptor for edge-triggered readiness, takes a reference */
+	bool Attach(int Target, AsReactorHandle* Handle, uint32_t Events = EPOLLIN | EPOLLOUT | EPOLLRDHUP)
+	{
+		epoll_event Event;
+		Event.events = Events | EPOLLET;
+		Event.data.ptr = (void*)Handle;
+		if (epoll_ctl(Fd, EPOLL_CTL_ADD, Target, &Event) != 0)
+			return false;
+
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Handles.insert(Handle);
+		return true;
+	}
+	/* Unregister descriptor, reference is released after current dispatch round */
+	void Detach(int Target, AsReactorHandle* Handle)
+	{
+		epoll_ctl(Fd, EPOLL_CTL_DEL, Target, nullptr);
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Handles.erase(Handle);
+		Unique.unlock();
+		Post([Handle]() { Handle->Release(); });
+	}
+	/* Queue a task to be executed by dispatching thread, thread safe */
+	void Post(std::function<void()>&& Callback)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		bool Signal = Posted.empty();
+		Posted.push_back(std::move(Callback));
+		Unique.unlock();
+		if (Signal)
+			Notify();
+	}
+	/* Execute a task by dispatching thread after timeout, thread safe */
+	void Schedule(uint64_t TimeoutMs, std::function<void()>&& Callback)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		uint64_t Deadline = AsGetTimestamp<std::chrono::milliseconds>() + TimeoutMs;
+		bool Signal = Timers.empty() || Deadline < Timers.top().Deadline;
+		Timers.push(Timer { Deadline, Sequence++, std::move(Callback) });
+		Unique.unlock();
+		if (Signal)
+			Notify();
+	}
+	/* Interrupt current wait, thread safe */
+	void Notify()
+	{
+		uint64_t Value = 1;
+		while (write(Wakeup, &Value, sizeof(Value)) < 0 && errno == EINTR);
+	}
+	/*
+		Wait for readiness, timers or posted tasks (up to timeout, -1 is infinite) and
+		handle all of them, returns count of handled events, tasks and timers
+	*/
+	size_t Dispatch(int TimeoutMs = -1)
+	{
+		epoll_event Events[PROMISE_REACTOR_EVENTS];
+		int Count = epoll_wait(Fd, Events, PROMISE_REACTOR_EVENTS, GetTimeout(TimeoutMs));
+		size_t Handled = 0;
+		for (int i = 0; i < Count; i++)
+		{
+			auto* Handle = (AsReactorHandle*)Events[i].data.ptr;
+			if (Handle != nullptr)
+			{
+				Handle->OnEvent(Events[i].events);
+				++Handled;
+			}
+			else
+			{
+				uint64_t Value;
+				while (read(Wakeup, &Value, sizeof(Value)) > 0);
+			}
+		}
+
+		/* Tasks run after descriptors so that detached handles outlive events of this round */
+		Handled += Expire();
+		Handled += Execute();
+		return Handled;
+	}
+	/* Check if any timers or tasks are waiting */
+	bool HasWork()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		return !Timers.empty() || !Posted.empty();
+	}
+
+private:
+	int GetTimeout(int TimeoutMs)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (!Posted.empty())
+			return 0;
+		if (Timers.empty())
+			return TimeoutMs;
+
+		uint64_t Time = AsGetTimestamp<std::chrono::milliseconds>(), Deadline = Timers.top().Deadline;
+		int Remaining = Deadline > Time ? (int)std::min<uint64_t>(Deadline - Time, (uint64_t)std::numeric_limits<int>::max()) : 0;
+		return TimeoutMs < 0 || Remaining < TimeoutMs ? Remaining : TimeoutMs;
+	}
+	size_t Expire()
+	{
+		size_t Handled = 0;
+		uint64_t Time = AsGetTimestamp<std::chrono::milliseconds>();
+		std::unique_lock<std::mutex> Unique(Mutex);
+		while (!Timers.empty() && Timers.top().Deadline <= Time)
+		{
+			auto Callback = std::move(const_cast<Timer&>(Timers.top()).Callback);
+			Timers.pop();
+			Unique.unlock();
+			Callback();
+			Unique.lock();
+			++Handled;
+		}
+		return Handled;
+	}
+	size_t Execute()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		std::vector<std::function<void()>> Tasks;
+		Tasks.swap(Posted);
+		Unique.unlock();
+		for (auto& Task : Tasks)
+			Task();
+		return Tasks.size();
+	}
+};
+
+/*
+	Non-blocking descriptor with FIFO queues of pending reads and writes,
+	operations are attempted eagerly and retried on readiness until they
+	stop returning -EAGAIN, completions are called without lock
+*/
+class AsReactorStream : public AsReactorHandle
+{
+public:
+	/* Perform syscall, returns result or negative errno, -EAGAIN to wait for readiness */
+	typedef std::function<int64_t(int)> Attempt;
+	typedef std::function<void(int64_t)> Completion;
+
+private:
+	struct Operation
+	{
+		Attempt Execute;
+		Completion Callback;
+	};
+	typedef std::vector<std::pair<Completion, int64_t>> Completions;
+
+private:
+	std::deque<Operation> Readers;
+	std::deque<Operation> Writers;
+	std::mutex Mutex;
+	std::atomic<uint32_t> RefCount;
+	AsReactor* Reactor;
+	int Fd;
+
+public:
+	/* Thread safe release */
+	void Release() override
+	{
+		PROMISE_ASSERT(RefCount > 0, "stream is already released");
+		if (!--RefCount)
+		{
+			this->~AsReactorStream();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		++RefCount;
+	}
+	/* Queue read-side operation (read, accept) */
+	void Read(Attempt&& Execute, Completion&& Callback)
+	{
+		Submit(Readers, std::move(Execute), std::move(Callback));
+	}
+	/* Queue write-side operation (write, connect) */
+	void Write(Attempt&& Execute, Completion&& Callback)
+	{
+		Submit(Writers, std::move(Execute), std::move(Callback));
+	}
+	/* Unregister and close descriptor, pending operations complete with -ECANCELED */
+	void Close() override
+	{
+		Completions Done;
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Fd < 0)
+			return;
+
+		Reactor->Detach(Fd, this);
+		close(Fd);
+		Fd = -1;
+		Cancel(Readers, Done);
+		Cancel(Writers, Done);
+		Unique.unlock();
+		for (auto& Item : Done)
+			Item.first(Item.second);
+	}
+	void OnEvent(uint32_t Events) override
+	{
+		Completions Done;
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+			Drain(Readers, Done);
+		if (Events & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+			Drain(Writers, Done);
+		Unique.unlock();
+		for (auto& Item : Done)
+			Item.first(Item.second);
+	}
+	int GetFd()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		return Fd;
+	}
+
+private:
+	AsReactorStream(AsReactor* NewReactor, int NewFd) noexcept : RefCount(2), Reactor(NewReactor), Fd(NewFd)
+	{
+	}
+	~AsReactorStream() override
+	{
+		PROMISE_ASSERT(Fd < 0, "stream should be closed before release");
+	}
+	void Submit(std::deque<Operation>& Queue, Attempt&& Execute, Completion&& Callback)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		int64_t Result = Fd < 0 ? -ECANCELED : -EAGAIN;
+		if (Fd >= 0 && Queue.empty())
+			Result = Execute(Fd);
+
+		if (Result == -EAGAIN)
+		{
+			Queue.push_back(Operation { std::move(Execute), std::move(Callback) });
+			return;
+		}
+
+		Unique.unlock();
+		Callback(Result);
+	}
+	void Drain(std::deque<Operation>& Queue, Completions& Done)
+	{
+		while (!Queue.empty() && Fd >= 0)
+		{
+			int64_t Result = Queue.front().Execute(Fd);
+			if (Result == -EAGAIN)
+				break;
+
+			Done.emplace_back(std::move(Queue.front().Callback), Result);
+			Queue.pop_front();
+		}
+	}
+	static void Cancel(std::deque<Operation>& Queue, Completions& Done)
+	{
+		for (auto& Next : Queue)
+			Done.emplace_back(std::move(Next.Callback), -ECANCELED);
+		Queue.clear();
+	}
+
+public:
+	/* Make descriptor non-blocking and register it, returns null and closes descriptor on failure */
+	static AsReactorStream* Create(AsReactor* Reactor, int Fd)
+	{
+		PROMISE_ASSERT(Reactor != nullptr, "reactor should not be null");
+		int Flags = fcntl(Fd, F_GETFL, 0);
+		if (Flags < 0 || fcntl(Fd, F_SETFL, Flags | O_NONBLOCK) < 0)
+		{
+			close(Fd);
+			return nullptr;
+		}
+
+		AsReactorStream* Stream = new(asAllocMem(sizeof(AsReactorStream))) AsReactorStream(Reactor, Fd);
+		if (!Reactor->Attach(Fd, Stream))
+		{
+			close(Fd);
+			Stream->Fd = -1;
+			Stream->Release();
+			Stream->Release();
+			return nullptr;
+		}
+
+		return Stream;
+	}
+	/* Normalize syscall result */
+	static int64_t GetResult(ssize_t Result)
+	{
+		return Result >= 0 ? (int64_t)Result : (errno == EWOULDBLOCK ? -EAGAIN : -(int64_t)errno);
+	}
+};
+#endif
+#if PROMISE_SOCKETS
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+/*
+	Script socket over reactor stream (TCP or Unix domain), operations settle
+	promises from readiness events, releasing last handle closes the socket
+*/
+template <typename Executor>
+class AsAsyncSocket
+{
+private:
+	typedef AsBasicPromise<Executor> Promise;
+	union Address
+	{
+		sockaddr Base;
+		sockaddr_in V4;
+		sockaddr_in6 V6;
+		sockaddr_un Unix;
+	};
+
+private:
+	std::atomic<uint32_t> RefCount;
+	asIScriptEngine* Engine;
+	AsReactorStream* Stream;
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		PROMISE_ASSERT(RefCount > 0, "socket is already released");
+		if (!--RefCount)
+		{
+			this->~AsAsyncSocket();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		++RefCount;
+	}
+	/* Read up to size bytes, empty array means end of stream */
+	Promise* Read(uint32_t Size)
+	{
+		Promise* Future = Promise::Create();
+		CScriptArray* Data = AsCreateByteArray(Engine, Size);
+		Future->AddRef();
+		Stream->Read([Data, Size](int Fd) { return AsReactorStream::GetResult(recv(Fd, Data->GetBuffer(), Size, 0)); }, [Future, Data](int64_t Result)
+		{
+			if (Result >= 0)
+			{
+				Data->Resize((asUINT)Result);
+				Future->Store((void*)&Data, Data->GetArrayTypeId() | asTYPEID_OBJHANDLE);
+			}
+			else
+				Future->RejectCode((int)-Result);
+			Data->Release();
+			Future->Release();
+		});
+		return Future;
+	}
+	/* Write copy of whole array taken at call, promise holds count of written bytes */
+	Promise* Write(const CScriptArray& Data)
+	{
+		Promise* Future = Promise::Create();
+		Future->AddRef();
+
+		auto Source = AsCopyByteArray(Data);
+		auto Offset = std::make_shared<size_t>(0);
+		Stream->Write([Source, Offset](int Fd) -> int64_t
+		{
+			while (*Offset < Source->size())
+			{
+				int64_t Result = AsReactorStream::GetResult(send(Fd, (const char*)Source->data() + *Offset, Source->size() - *Offset, MSG_NOSIGNAL));
+				if (Result < 0)
+					return Result;
+				*Offset += (size_t)Result;
+			}
+			return (int64_t)Source->size();
+		}, [Future](int64_t Result)
+		{
+			if (Result >= 0)
+			{
+				uint32_t Written = (uint32_t)Result;
+				Future->Store(&Written, asTYPEID_UINT32);
+			}
+			else
+				Future->RejectCode((int)-Result);
+			Future->Release();
+		});
+		return Future;
+	}
+	/* Accept next connection of listening socket */
+	Promise* Accept()
+	{
+		Promise* Future = Promise::Create();
+		Future->AddRef();
+		asIScriptEngine* Target = Engine;
+		Stream->Read([](int Fd) { return AsReactorStream::GetResult(accept4(Fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)); }, [Future, Target](int64_t Result)
+		{
+			Settle(Future, Target, Result >= 0 ? Wrap(Target, (int)Result) : nullptr, Result);
+		});
+		return Future;
+	}
+	/* Close socket, pending operations are rejected with ECANCELED */
+	void Close()
+	{
+		Stream->Close();
+	}
+	bool IsOpen()
+	{
+		return Stream->GetFd() >= 0;
+	}
+
+private:
+	AsAsyncSocket(asIScriptEngine* NewEngine, AsReactorStream* NewStream) noexcept : RefCount(1), Engine(NewEngine), Stream(NewStream)
+	{
+	}
+	~AsAsyncSocket()
+	{
+		Stream->Close();
+		Stream->Release();
+	}
+
+public:
+	/* Connect to "host:port", "[host]:port" or "unix:path", host must be a numeric address or localhost */
+	static Promise* Connect(const std::string& Location)
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		PROMISE_ASSERT(Context != nullptr, "socket should be created from script context");
+		asIScriptEngine* Target = Context->GetEngine();
+		Promise* Future = Promise::Create(Context);
+		Address Peer; socklen_t Size;
+		int Fd = Resolve(Location, Peer, Size);
+		if (Fd < 0)
+		{
+			Future->RejectCode(-Fd);
+			return Future;
+		}
+
+		int Status = connect(Fd, &Peer.Base, Size);
+		if (Status < 0 && errno != EINPROGRESS)
+		{
+			Future->RejectCode(errno);
+			close(Fd);
+			return Future;
+		}
+
+		AsAsyncSocket* Socket = Wrap(Target, Fd);
+		if (!Socket)
+		{
+			Future->RejectCode(EBADF);
+			return Future;
+		}
+
+		Future->AddRef();
+		Socket->Stream->Write([](int Fd) -> int64_t
+		{
+			int Error = 0; socklen_t Length = sizeof(Error);
+			if (getsockopt(Fd, SOL_SOCKET, SO_ERROR, &Error, &Length) < 0)
+				return -(int64_t)errno;
+			if (Error != 0)
+				return -(int64_t)Error;
+
+			sockaddr_storage Remote; socklen_t RemoteSize = sizeof(Remote);
+			if (getpeername(Fd, (sockaddr*)&Remote, &RemoteSize) == 0)
+				return 0;
+			return errno == ENOTCONN ? -EAGAIN : -(int64_t)errno;
+		}, [Future, Target, Socket](int64_t Result)
+		{
+			if (Result < 0)
+				Socket->Close();
+			Settle(Future, Target, Socket, Result);
+		});
+		return Future;
+	}
+	/* Bind and listen on address, returns null on failure */
+	static AsAsyncSocket* Listen(const std::string& Location, int Backlog)
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		PROMISE_ASSERT(Context != nullptr, "socket should be created from script context");
+		Address Local; socklen_t Size;
+		int Fd = Resolve(Location, Local, Size);
+		if (Fd < 0)
+			return nullptr;
+
+		int Reuse = 1;
+		setsockopt(Fd, SOL_SOCKET, SO_REUSEADDR, &Reuse, sizeof(Reuse));
+		if (bind(Fd, &Local.Base, Size) < 0 || listen(Fd, Backlog) < 0)
+		{
+			close(Fd);
+			return nullptr;
+		}
+
+		return Wrap(Context->GetEngine(), Fd);
+	}
+	/* Register socket type and functions, reactor should outlive the engine */
+	static void Register(asIScriptEngine* Engine, AsReactor* Reactor)
+	{
+		using Type = AsAsyncSocket<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_ASSERT(Reactor != nullptr, "reactor should not be null");
+		Engine->SetUserData((void*)Reactor, PROMISE_USERID + 4);
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_SOCKET, 0, asOBJ_REF));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_SOCKET, asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_SOCKET, asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SOCKET, PROMISE_TYPENAME "<array<uint8>@>@ read(uint)", asMETHOD(Type, Read), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SOCKET, PROMISE_TYPENAME "<uint>@ write(const array<uint8>&in)", asMETHOD(Type, Write), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SOCKET, PROMISE_TYPENAME "<" PROMISE_SOCKET "@>@ accept()", asMETHOD(Type, Accept), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SOCKET, "void close()", asMETHOD(Type, Close), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_SOCKET, "bool is_open()", asMETHOD(Type, IsOpen), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME "<" PROMISE_SOCKET "@>@ connect(const string&in)", asFUNCTION(Type::Connect), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_SOCKET "@ listen(const string&in, int = 128)", asFUNCTION(Type::Listen), asCALL_CDECL));
+	}
+
+private:
+	/* Wrap connected or listening descriptor, descriptor is closed on failure */
+	static AsAsyncSocket* Wrap(asIScriptEngine* Engine, int Fd)
+	{
+		AsReactor* Reactor = (AsReactor*)Engine->GetUserData(PROMISE_USERID + 4);
+		PROMISE_ASSERT(Reactor != nullptr, "sockets are not registered for this engine");
+		AsReactorStream* Stream = AsReactorStream::Create(Reactor, Fd);
+		if (!Stream)
+			return nullptr;
+
+		int NoDelay = 1;
+		setsockopt(Fd, IPPROTO_TCP, TCP_NODELAY, &NoDelay, sizeof(NoDelay));
+		return new(asAllocMem(sizeof(AsAsyncSocket))) AsAsyncSocket(Engine, Stream);
+	}
+	/* Settle promise with socket handle or errno, consumes promise and socket references */
+	static void Settle(Promise* Future, asIScriptEngine* Engine, AsAsyncSocket* Socket, int64_t Result)
+	{
+		if (Result >= 0 && Socket != nullptr)
+		{
+			int TypeId = Engine->GetTypeInfoByName(PROMISE_SOCKET)->GetTypeId() | asTYPEID_OBJHANDLE;
+			Future->Store((void*)&Socket, TypeId);
+		}
+		else
+			Future->RejectCode(Result < 0 ? (int)-Result : EBADF);
+		if (Socket != nullptr)
+			Socket->Release();
+		Future->Release();
+	}
+	/* Parse address and create matching non-blocking socket, returns negative errno on failure */
+	static int Resolve(const std::string& Location, Address& Target, socklen_t& Size)
+	{
+		memset(&Target, 0, sizeof(Target));
+		if (Location.compare(0, 5, "unix:") == 0)
+		{
+			std::string Path = Location.substr(5);
+			if (Path.empty() || Path.size() >= sizeof(Target.Unix.sun_path))
+				return -EINVAL;
+
+			Target.Unix.sun_family = AF_UNIX;
+			memcpy(Target.Unix.sun_path, Path.c_str(), Path.size());
+			Size = (socklen_t)(offsetof(sockaddr_un, sun_path) + Path.size() + 1);
+		}
+		else
+		{
+			size_t Split = Location.rfind(':');
+			if (Split == std::string::npos)
+				return -EINVAL;
+
+			std::string Host = Location.substr(0, Split);
+			int Port = atoi(Location.c_str() + Split + 1);
+			if (Port <= 0 || Port > 65535)
+				return -EINVAL;
+
+			if (Host.size() > 1 && Host.front() == '[' && Host.back() == ']')
+				Host = Host.substr(1, Host.size() - 2);
+			else if (Host == "localhost")
+				Host = "127.0.0.1";
+
+			if (inet_pton(AF_INET, Host.c_str(), &Target.V4.sin_addr) == 1)
+			{
+				Target.V4.sin_family = AF_INET;
+				Target.V4.sin_port = htons((uint16_t)Port);
+				Size = sizeof(Target.V4);
+			}
+			else if (inet_pton(AF_INET6, Host.c_str(), &Target.V6.sin6_addr) == 1)
+			{
+				Target.V6.sin6_family = AF_INET6;
+				Target.V6.sin6_port = htons((uint16_t)Port);
+				Size = sizeof(Target.V6);
+			}
+			else
+				return -EINVAL;
+		}
+
+		int Fd = socket(Target.Base.sa_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+		return Fd >= 0 ? Fd : -errno;
+	}
+};
+
+/* Register socket module, promise interface and array<T> should be registered first */
+template <typename Executor>
+static void AsRegisterSockets(asIScriptEngine* Engine, AsReactor* Reactor)
+{
+	AsAsyncSocket<Executor>::Register(Engine, Reactor);
+}
+#endif
+#if PROMISE_PROCESSES
+#include <signal.h>
+#include <spawn.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+/* Captured output and exit code of finished child process */
+class AsProcessResult
+{
+private:
+	std::atomic<uint32_t> RefCount;
+	CScriptArray* Output;
+	CScriptArray* Errors;
+	int ExitCode;
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		PROMISE_ASSERT(RefCount > 0, "process result is already released");
+		if (!--RefCount)
+		{
+			this->~AsProcessResult();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		++RefCount;
+	}
+	/* Exit status of child, negative signal number if it was terminated by signal */
+	int GetExitCode()
+	{
+		return ExitCode;
+	}
+	CScriptArray* GetOutput()
+	{
+		Output->AddRef();
+		return Output;
+	}
+	CScriptArray* GetErrors()
+	{
+		Errors->AddRef();
+		return Errors;
+	}
+
+private:
+	AsProcessResult(CScriptArray* NewOutput, CScriptArray* NewErrors, int NewExitCode) noexcept : RefCount(1), Output(NewOutput), Errors(NewErrors), ExitCode(NewExitCode)
+	{
+	}
+	~AsProcessResult()
+	{
+		Output->Release();
+		Errors->Release();
+	}
+
+public:
+	/* Takes references to both arrays */
+	static AsProcessResult* Create(CScriptArray* Output, CScriptArray* Errors, int ExitCode)
+	{
+		return new(asAllocMem(sizeof(AsProcessResult))) AsProcessResult(Output, Errors, ExitCode);
+	}
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsProcessResult;
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_PROCESSRESULT, 0, asOBJ_REF));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_PROCESSRESULT, asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_PROCESSRESULT, asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESSRESULT, "int exit_code()", asMETHOD(Type, GetExitCode), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESSRESULT, "array<uint8>@ output()", asMETHOD(Type, GetOutput), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESSRESULT, "array<uint8>@ error_output()", asMETHOD(Type, GetErrors), asCALL_THISCALL));
+	}
+};
+
+/*
+	Child process started with posix_spawn, standard streams are non-blocking
+	pipes watched by reactor and exit is observed through pidfd (or reactor timer
+	polling waitpid on older kernels), no thread is held per child, process keeps
+	itself alive until child is reaped
+*/
+template <typename Executor>
+class AsAsyncProcess
+{
+private:
+	typedef AsBasicPromise<Executor> Promise;
+	typedef std::function<void(int64_t)> ExitCallback;
+	struct Collector
+	{
+		std::vector<uint8_t> Output;
+		std::vector<uint8_t> Errors;
+		std::atomic<uint32_t> Pending;
+		AsAsyncProcess* Process = nullptr;
+		Promise* Future = nullptr;
+		int64_t Status = 0;
+	};
+
+private:
+	std::vector<ExitCallback> Listeners;
+	std::atomic<uint32_t> RefCount;
+	std::mutex Mutex;
+	asIScriptEngine* Engine;
+	AsReactor* Reactor;
+	AsReactorStream* Input;
+	AsReactorStream* Output;
+	AsReactorStream* Errors;
+	AsReactorStream* Exit;
+	int64_t Status;
+	pid_t Pid;
+	bool Reaped;
+	bool Exited;
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		PROMISE_ASSERT(RefCount > 0, "process is already released");
+		if (!--RefCount)
+		{
+			this->~AsAsyncProcess();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		++RefCount;
+	}
+	/* Read up to size bytes of standard output, empty array means end of stream */
+	Promise* Read(uint32_t Size)
+	{
+		return ReadFrom(Output, Size);
+	}
+	/* Read up to size bytes of standard error, empty array means end of stream */
+	Promise* ReadError(uint32_t Size)
+	{
+		return ReadFrom(Errors, Size);
+	}
+	/* Write copy of whole array to standard input, promise holds count of written bytes */
+	Promise* Write(const CScriptArray& Data)
+	{
+		Promise* Future = Promise::Create();
+		Future->AddRef();
+		WriteTo(Input, AsCopyByteArray(Data), [Future](int64_t Result)
+		{
+			if (Result >= 0)
+			{
+				uint32_t Written = (uint32_t)Result;
+				Future->Store(&Written, asTYPEID_UINT32);
+			}
+			else
+				Future->RejectCode((int)-Result);
+			Future->Release();
+		});
+		return Future;
+	}
+	/* Close standard input so that child receives end of stream */
+	void CloseInput()
+	{
+		Input->Close();
+	}
+	/* Settled with exit code when child exits, negative signal number if it was killed */
+	Promise* Wait()
+	{
+		Promise* Future = Promise::Create();
+		Future->AddRef();
+		OnExit([Future](int64_t Result)
+		{
+			if (Result >= 0)
+			{
+				int ExitCode = Decode(Result);
+				Future->Store(&ExitCode, asTYPEID_INT32);
+			}
+			else
+				Future->RejectCode((int)-Result);
+			Future->Release();
+		});
+		return Future;
+	}
+	/*
+		Send signal to child that was not reaped yet, signal goes through
+		pidfd when it is available so it cannot reach a recycled pid
+	*/
+	bool Kill(int Signal)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Exited)
+			return false;
+#ifdef SYS_pidfd_send_signal
+		if (Exit != nullptr)
+		{
+			int Handle = Exit->GetFd();
+			return Handle >= 0 && syscall(SYS_pidfd_send_signal, Handle, Signal, nullptr, 0) == 0;
+		}
+#endif
+		return !Reaped && kill(Pid, Signal) == 0;
+	}
+	int GetPid()
+	{
+		return (int)Pid;
+	}
+
+private:
+	AsAsyncProcess(asIScriptEngine* NewEngine, AsReactor* NewReactor, pid_t NewPid) noexcept : RefCount(1), Engine(NewEngine), Reactor(NewReactor), Input(nullptr), Output(nullptr), Errors(nullptr), Exit(nullptr), Status(0), Pid(NewPid), Reaped(false), Exited(false)
+	{
+	}
+	~AsAsyncProcess()
+	{
+		for (auto* Stream : { Input, Output, Errors, Exit })
+		{
+			if (Stream != nullptr)
+			{
+				Stream->Close();
+				Stream->Release();
+			}
+		}
+	}
+	Promise* ReadFrom(AsReactorStream* Stream, uint32_t Size)
+	{
+		Promise* Future = Promise::Create();
+		CScriptArray* Data = AsCreateByteArray(Engine, Size);
+		Future->AddRef();
+		Stream->Read([Data, Size](int Fd) { return AsReactorStream::GetResult(read(Fd, Data->GetBuffer(), Size)); }, [Future, Data](int64_t Result)
+		{
+			if (Result >= 0)
+			{
+				Data->Resize((asUINT)Result);
+				Future->Store((void*)&Data, Data->GetArrayTypeId() | asTYPEID_OBJHANDLE);
+			}
+			else
+				Future->RejectCode((int)-Result);
+			Data->Release();
+			Future->Release();
+		});
+		return Future;
+	}
+	/* Call listener with raw wait status or negative errno once child is reaped */
+	void OnExit(ExitCallback&& Callback)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (!Exited)
+			return Listeners.push_back(std::move(Callback));
+
+		Unique.unlock();
+		Callback(Status);
+	}
+	void Finish(int64_t Result)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Status = Result;
+		Exited = true;
+		std::vector<ExitCallback> Ready;
+		Ready.swap(Listeners);
+		Unique.unlock();
+		for (auto& Callback : Ready)
+			Callback(Result);
+		Release();
+	}
+	/* Watch for exit through pidfd, timer polling is used when pidfd is not supported */
+	void Watch()
+	{
+		AddRef();
+		int Fd = -1;
+#ifdef SYS_pidfd_open
+		Fd = (int)syscall(SYS_pidfd_open, Pid, 0);
+#endif
+		Exit = Fd >= 0 ? AsReactorStream::Create(Reactor, Fd) : nullptr;
+		if (!Exit)
+			return Poll(1);
+
+		pid_t Target = Pid;
+		Exit->Read([Target](int) { return Reap(Target); }, [this](int64_t Result) { Finish(Result); });
+	}
+	/* Reaped under lock so that kill without pidfd is not sent to a recycled pid */
+	void Poll(uint64_t Delay)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		int64_t Result = Reap(Pid);
+		Reaped = Result != -EAGAIN;
+		Unique.unlock();
+		if (Result != -EAGAIN)
+			return Finish(Result);
+
+		Reactor->Schedule(Delay, [this, Delay]() { Poll(std::min<uint64_t>(Delay * 2, 100)); });
+	}
+
+private:
+	/* Raw wait status, -EAGAIN while child is running */
+	static int64_t Reap(pid_t Pid)
+	{
+		int Result = 0;
+		pid_t Status = waitpid(Pid, &Result, WNOHANG);
+		if (Status == 0 || (Status < 0 && errno == EINTR))
+			return -EAGAIN;
+		else if (Status < 0)
+			return -(int64_t)errno;
+
+		return (int64_t)(uint32_t)Result;
+	}
+	static int Decode(int64_t Status)
+	{
+		int Result = (int)Status;
+		if (WIFEXITED(Result))
+			return WEXITSTATUS(Result);
+
+		return WIFSIGNALED(Result) ? -WTERMSIG(Result) : 0;
+	}
+	/* Write to pipe without raising SIGPIPE if child has closed it's end */
+	static int64_t WritePipe(int Fd, const uint8_t* Data, size_t Size)
+	{
+		sigset_t Pipe, Previous;
+		sigemptyset(&Pipe);
+		sigaddset(&Pipe, SIGPIPE);
+		pthread_sigmask(SIG_BLOCK, &Pipe, &Previous);
+
+		int64_t Result = AsReactorStream::GetResult(write(Fd, Data, Size));
+		if (Result == -EPIPE)
+		{
+			timespec Zero = { 0, 0 };
+			sigtimedwait(&Pipe, nullptr, &Zero);
+		}
+
+		pthread_sigmask(SIG_SETMASK, &Previous, nullptr);
+		return Result;
+	}
+	/* Write whole buffer, buffer is owned by write until completion */
+	static void WriteTo(AsReactorStream* Stream, const std::shared_ptr<std::vector<uint8_t>>& Source, AsReactorStream::Completion&& Callback)
+	{
+		auto Offset = std::make_shared<size_t>(0);
+		Stream->Write([Source, Offset](int Fd) -> int64_t
+		{
+			while (*Offset < Source->size())
+			{
+				int64_t Result = WritePipe(Fd, Source->data() + *Offset, Source->size() - *Offset);
+				if (Result < 0)
+					return Result;
+				*Offset += (size_t)Result;
+			}
+			return (int64_t)Source->size();
+		}, std::move(Callback));
+	}
+	/* Read until end of stream, data is appended as it arrives */
+	static void Collect(AsReactorStream* Stream, const std::shared_ptr<Collector>& Base, std::vector<uint8_t>* Target)
+	{
+		Stream->Read([Target](int Fd) -> int64_t
+		{
+			uint8_t Chunk[16384];
+			while (true)
+			{
+				int64_t Result = AsReactorStream::GetResult(read(Fd, Chunk, sizeof(Chunk)));
+				if (Result <= 0)
+					return Result;
+				Target->insert(Target->end(), Chunk, Chunk + Result);
+			}
+		}, [Base](int64_t) { Complete(Base); });
+	}
+	/* Settle run promise when both outputs are drained and child is reaped */
+	static void Complete(const std::shared_ptr<Collector>& Base)
+	{
+		if (--Base->Pending > 0)
+			return;
+
+		AsAsyncProcess* Process = Base->Process;
+		Promise* Future = Base->Future;
+		if (Base->Status >= 0)
+		{
+			CScriptArray* Output = AsCreateByteArray(Process->Engine, (asUINT)Base->Output.size());
+			CScriptArray* Errors = AsCreateByteArray(Process->Engine, (asUINT)Base->Errors.size());
+			if (!Base->Output.empty())
+				memcpy(Output->GetBuffer(), Base->Output.data(), Base->Output.size());
+			if (!Base->Errors.empty())
+				memcpy(Errors->GetBuffer(), Base->Errors.data(), Base->Errors.size());
+
+			AsProcessResult* Result = AsProcessResult::Create(Output, Errors, Decode(Base->Status));
+			int TypeId = Process->Engine->GetTypeInfoByName(PROMISE_PROCESSRESULT)->GetTypeId() | asTYPEID_OBJHANDLE;
+			Future->Store((void*)&Result, TypeId);
+			Result->Release();
+		}
+		else
+			Future->RejectCode((int)-Base->Status);
+		Future->Release();
+		Process->Release();
+	}
+
+public:
+	/* Spawn child with piped standard streams, returns null and sets errno code on failure */
+	static AsAsyncProcess* Start(asIScriptEngine* Engine, const std::string& Command, const CScriptArray* Args, int& Error)
+	{
+		AsReactor* Reactor = (AsReactor*)Engine->GetUserData(PROMISE_USERID + 4);
+		PROMISE_ASSERT(Reactor != nullptr, "processes are not registered for this engine");
+		int Pipes[3][2] = { { -1, -1 }, { -1, -1 }, { -1, -1 } };
+		for (auto& Pipe : Pipes)
+		{
+			if (pipe2(Pipe, O_CLOEXEC) == 0)
+				continue;
+
+			Error = errno;
+			for (auto& Next : Pipes)
+			{
+				if (Next[0] >= 0)
+					close(Next[0]);
+				if (Next[1] >= 0)
+					close(Next[1]);
+			}
+			return nullptr;
+		}
+
+		std::vector<char*> Argv;
+		Argv.push_back((char*)Command.c_str());
+		for (asUINT i = 0; Args != nullptr && i < Args->GetSize(); i++)
+			Argv.push_back((char*)((const std::string*)Args->At(i))->c_str());
+		Argv.push_back(nullptr);
+
+		posix_spawn_file_actions_t Actions;
+		posix_spawn_file_actions_init(&Actions);
+		posix_spawn_file_actions_adddup2(&Actions, Pipes[0][0], STDIN_FILENO);
+		posix_spawn_file_actions_adddup2(&Actions, Pipes[1][1], STDOUT_FILENO);
+		posix_spawn_file_actions_adddup2(&Actions, Pipes[2][1], STDERR_FILENO);
+
+		pid_t Pid = -1;
+		Error = posix_spawnp(&Pid, Command.c_str(), &Actions, nullptr, Argv.data(), environ);
+		posix_spawn_file_actions_destroy(&Actions);
+		close(Pipes[0][0]);
+		close(Pipes[1][1]);
+		close(Pipes[2][1]);
+		if (Error != 0)
+		{
+			close(Pipes[0][1]);
+			close(Pipes[1][0]);
+			close(Pipes[2][0]);
+			return nullptr;
+		}
+
+		AsAsyncProcess* Process = new(asAllocMem(sizeof(AsAsyncProcess))) AsAsyncProcess(Engine, Reactor, Pid);
+		Process->Input = AsReactorStream::Create(Reactor, Pipes[0][1]);
+		Process->Output = AsReactorStream::Create(Reactor, Pipes[1][0]);
+		Process->Errors = AsReactorStream::Create(Reactor, Pipes[2][0]);
+		Process->Watch();
+		if (!Process->Input || !Process->Output || !Process->Errors)
+		{
+			/* Child is still reaped by watcher */
+			Error = EMFILE;
+			Process->Kill(SIGKILL);
+			Process->Release();
+			return nullptr;
+		}
+
+		return Process;
+	}
+	/* Start process for streaming, returns null on failure */
+	static AsAsyncProcess* Spawn(const std::string& Command, const CScriptArray* Args)
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		PROMISE_ASSERT(Context != nullptr, "process should be started from script context");
+		int Error = 0;
+		return Start(Context->GetEngine(), Command, Args, Error);
+	}
+	/* Run process to completion, input is written and closed, both outputs are captured */
+	static Promise* Run(const std::string& Command, const CScriptArray* Args, const CScriptArray* Data)
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		PROMISE_ASSERT(Context != nullptr, "process should be started from script context");
+		Promise* Future = Promise::Create(Context);
+		int Error = 0;
+		AsAsyncProcess* Process = Start(Context->GetEngine(), Command, Args, Error);
+		if (!Process)
+		{
+			Future->RejectCode(Error);
+			return Future;
+		}
+
+		auto Base = std::make_shared<Collector>();
+		Base->Pending = 3;
+		Base->Process = Process;
+		Base->Future = Future;
+		Future->AddRef();
+		if (Data != nullptr && Data->GetSize() > 0)
+		{
+			Process->AddRef();
+			WriteTo(Process->Input, AsCopyByteArray(*Data), [Process](int64_t)
+			{
+				Process->CloseInput();
+				Process->Release();
+			});
+		}
+		else
+			Process->Input->Close();
+
+		Collect(Process->Output, Base, &Base->Output);
+		Collect(Process->Errors, Base, &Base->Errors);
+		Process->OnExit([Base](int64_t Result)
+		{
+			Base->Status = Result;
+			Complete(Base);
+		});
+		return Future;
+	}
+	/* Register process types and functions, reactor should outlive the engine */
+	static void Register(asIScriptEngine* Engine, AsReactor* Reactor)
+	{
+		using Type = AsAsyncProcess<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_ASSERT(Reactor != nullptr, "reactor should not be null");
+		Engine->SetUserData((void*)Reactor, PROMISE_USERID + 4);
+		AsProcessResult::Register(Engine);
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_PROCESS, 0, asOBJ_REF));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_PROCESS, asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_PROCESS, asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESS, PROMISE_TYPENAME "<array<uint8>@>@ read(uint)", asMETHOD(Type, Read), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESS, PROMISE_TYPENAME "<array<uint8>@>@ read_error(uint)", asMETHOD(Type, ReadError), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESS, PROMISE_TYPENAME "<uint>@ write(const array<uint8>&in)", asMETHOD(Type, Write), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESS, "void close_input()", asMETHOD(Type, CloseInput), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESS, PROMISE_TYPENAME "<int>@ wait()", asMETHOD(Type, Wait), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESS, "bool kill(int = 15)", asMETHOD(Type, Kill), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_PROCESS, "int pid()", asMETHOD(Type, GetPid), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME "<" PROMISE_PROCESSRESULT "@>@ run(const string&in, const array<string>@+ = null, const array<uint8>@+ = null)", asFUNCTION(Type::Run), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_PROCESS "@ spawn_process(const string&in, const array<string>@+ = null)", asFUNCTION(Type::Spawn), asCALL_CDECL));
+	}
+};
+
+/* Register subprocess module, promise interface, array<T> and string should be registered first */
+template <typename Executor>
+static void AsRegisterProcesses(asIScriptEngine* Engine, AsReactor* Reactor)
+{
+	AsAsyncProcess<Executor>::Register(Engine, Reactor);
+}
+#endif
+#if PROMISE_BRIDGE
+#ifndef __linux__
+#error "promise bridge requires linux (futex)"
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+/*
+	Region of process shared slots, each slot pairs a pending promise of one
+	endpoint (process) with a settler that may live in any process mapping the
+	region, settled slots are pushed to owner's ready list and owner's futex
+	doorbell is rung, slot and list links are indices so mapping address may differ
+*/
+class AsPromiseBridge
+{
+public:
+	enum : uint32_t
+	{
+		Free = 0,
+		Pending,
+		Writing,
+		Fulfilled,
+		Rejected
+	};
+	enum : int32_t
+	{
+		Bytes = -2
+	};
+	struct Slot
+	{
+		std::atomic<uint32_t> State;
+		std::atomic<uint32_t> Next;
+		uint32_t Owner;
+		int32_t TypeId;
+		int32_t ErrorCode;
+		uint32_t Size;
+		uint64_t Value;
+	};
+	struct alignas(64) Endpoint
+	{
+		std::atomic<uint32_t> Doorbell;
+		std::atomic<uint32_t> Ready;
+	};
+	struct Header
+	{
+		uint32_t Magic;
+		uint32_t Capacity;
+		uint32_t PayloadSize;
+		uint32_t Stride;
+		uint64_t Size;
+		std::atomic<uint64_t> Free;
+		Endpoint Endpoints[PROMISE_BRIDGE_ENDPOINTS];
+	};
+
+private:
+	Header* Base;
+	size_t Size;
+
+public:
+	AsPromiseBridge(const AsPromiseBridge&) = delete;
+	AsPromiseBridge& operator= (const AsPromiseBridge&) = delete;
+	~AsPromiseBridge()
+	{
+		munmap((void*)Base, Size);
+	}
+	/* Take a free slot owned by endpoint, returns false if region is full */
+	bool Allocate(uint32_t Owner, uint32_t* Index)
+	{
+		PROMISE_ASSERT(Owner < PROMISE_BRIDGE_ENDPOINTS, "invalid endpoint");
+		uint64_t Head = Base->Free.load(std::memory_order_acquire);
+		while (true)
+		{
+			uint32_t Top = (uint32_t)Head;
+			if (!Top)
+				return false;
+
+			uint64_t Next = ((Head >> 32) + 1) << 32 | GetSlot(Top - 1)->Next.load(std::memory_order_relaxed);
+			if (Base->Free.compare_exchange_weak(Head, Next, std::memory_order_acq_rel, std::memory_order_acquire))
+			{
+				Slot* Target = GetSlot(Top - 1);
+				Target->Owner = Owner;
+				Target->State.store(Pending, std::memory_order_release);
+				*Index = Top - 1;
+				return true;
+			}
+		}
+	}
+	/* Settle slot with primitive value (asTYPEID_BOOL to asTYPEID_DOUBLE) or void */
+	bool Fulfill(uint32_t Index, const void* Value = nullptr, int TypeId = asTYPEID_VOID)
+	{
+		uint32_t Bytes = GetPrimitiveSize(TypeId);
+		PROMISE_ASSERT(Value != nullptr || !Bytes, "primitive value should not be null");
+		Slot* Target = Begin(Index);
+		if (!Target)
+			return false;
+
+		Target->TypeId = TypeId;
+		Target->Size = Bytes;
+		Target->Value = 0;
+		if (Bytes > 0)
+			memcpy(&Target->Value, Value, Bytes);
+		Commit(Target, Fulfilled);
+		return true;
+	}
+	/* Settle slot with flat byte payload, received as array<uint8> */
+	bool FulfillBytes(uint32_t Index, const void* Data, uint32_t Length)
+	{
+		PROMISE_ASSERT(Length <= Base->PayloadSize, "payload is too large for bridge slot");
+		if (Length > Base->PayloadSize)
+			return false;
+
+		Slot* Target = Begin(Index);
+		if (!Target)
+			return false;
+
+		Target->TypeId = Bytes;
+		Target->Size = Length;
+		if (Length > 0)
+			memcpy(GetPayload(Target), Data, Length);
+		Commit(Target, Fulfilled);
+		return true;
+	}
+	/* Settle slot with error code */
+	bool Reject(uint32_t Index, int Code)
+	{
+		Slot* Target = Begin(Index);
+		if (!Target)
+			return false;
+
+		Target->ErrorCode = Code;
+		Target->TypeId = asTYPEID_VOID;
+		Target->Size = 0;
+		Commit(Target, Rejected);
+		return true;
+	}
+	/* Take all settled slots of endpoint, returns first slot index plus one, zero if none */
+	uint32_t Collect(uint32_t Owner)
+	{
+		return Base->Endpoints[Owner].Ready.exchange(0, std::memory_order_acq_rel);
+	}
+	/* Return collected slot to free list */
+	void Release(uint32_t Index)
+	{
+		Slot* Target = GetSlot(Index);
+		Target->State.store(Free, std::memory_order_relaxed);
+		uint64_t Head = Base->Free.load(std::memory_order_relaxed);
+		do
+		{
+			Target->Next.store((uint32_t)Head, std::memory_order_relaxed);
+		} while (!Base->Free.compare_exchange_weak(Head, ((Head >> 32) + 1) << 32 | (Index + 1), std::memory_order_release, std::memory_order_relaxed));
+	}
+	/* Block until doorbell of endpoint changes from seen value or timeout expires */
+	void Wait(uint32_t Owner, uint32_t Seen, uint32_t TimeoutMs)
+	{
+		timespec Timeout;
+		Timeout.tv_sec = TimeoutMs / 1000;
+		Timeout.tv_nsec = (long)(TimeoutMs % 1000) * 1000000;
+		syscall(SYS_futex, (uint32_t*)&Base->Endpoints[Owner].Doorbell, FUTEX_WAIT, Seen, &Timeout, nullptr, 0);
+	}
+	/* Ring doorbell of endpoint */
+	void Wake(uint32_t Owner)
+	{
+		Base->Endpoints[Owner].Doorbell.fetch_add(1, std::memory_order_release);
+		syscall(SYS_futex, (uint32_t*)&Base->Endpoints[Owner].Doorbell, FUTEX_WAKE, 1, nullptr, nullptr, 0);
+	}
+	uint32_t GetDoorbell(uint32_t Owner)
+	{
+		return Base->Endpoints[Owner].Doorbell.load(std::memory_order_acquire);
+	}
+	uint32_t GetCapacity() const
+	{
+		return Base->Capacity;
+	}
+	Slot* GetSlot(uint32_t Index)
+	{
+		PROMISE_ASSERT(Index < Base->Capacity, "invalid slot index");
+		return (Slot*)((char*)Base + sizeof(Header) + (size_t)Index * Base->Stride);
+	}
+	static void* GetPayload(Slot* Target)
+	{
+		return (void*)(Target + 1);
+	}
+
+private:
+	AsPromiseBridge(Header* NewBase, size_t NewSize) noexcept : Base(NewBase), Size(NewSize)
+	{
+	}
+	Slot* Begin(uint32_t Index)
+	{
+		Slot* Target = GetSlot(Index);
+		uint32_t Expected = Pending;
+		if (!Target->State.compare_exchange_strong(Expected, Writing, std::memory_order_acquire, std::memory_order_relaxed))
+			return nullptr;
+
+		return Target;
+	}
+	void Commit(Slot* Target, uint32_t Status)
+	{
+		uint32_t Index = (uint32_t)(((char*)Target - ((char*)Base + sizeof(Header))) / Base->Stride);
+		Target->State.store(Status, std::memory_order_release);
+
+		Endpoint& Owner = Base->Endpoints[Target->Owner];
+		uint32_t Head = Owner.Ready.load(std::memory_order_relaxed);
+		do
+		{
+			Target->Next.store(Head, std::memory_order_relaxed);
+		} while (!Owner.Ready.compare_exchange_weak(Head, Index + 1, std::memory_order_release, std::memory_order_relaxed));
+		Wake(Target->Owner);
+	}
+
+public:
+	/*
+		Create a region, named regions use shm_open and can be opened by unrelated processes,
+		anonymous ones (null name) are shared with children forked after creation
+	*/
+	static AsPromiseBridge* Create(const char* Name, uint32_t Capacity, uint32_t PayloadSize)
+	{
+		static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "process shared atomics should be lock-free");
+		PROMISE_ASSERT(Capacity > 0, "bridge should have at least one slot");
+		uint32_t Stride = (uint32_t)((sizeof(Slot) + PayloadSize + 63) & ~(size_t)63);
+		size_t Bytes = sizeof(Header) + (size_t)Capacity * Stride;
+		void* Address = MAP_FAILED;
+		if (Name != nullptr)
+		{
+			int Fd = shm_open(Name, O_RDWR | O_CREAT | O_EXCL, 0600);
+			if (Fd < 0)
+				return nullptr;
+
+			if (ftruncate(Fd, (off_t)Bytes) == 0)
+				Address = mmap(nullptr, Bytes, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+			close(Fd);
+			if (Address == MAP_FAILED)
+				shm_unlink(Name);
+		}
+		else
+			Address = mmap(nullptr, Bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+
+		if (Address == MAP_FAILED)
+			return nullptr;
+
+		Header* Base = new(Address) Header();
+		Base->Capacity = Capacity;
+		Base->PayloadSize = PayloadSize;
+		Base->Stride = Stride;
+		Base->Size = Bytes;
+		for (uint32_t i = 0; i < PROMISE_BRIDGE_ENDPOINTS; i++)
+		{
+			new(&Base->Endpoints[i].Doorbell) std::atomic<uint32_t>(0);
+			new(&Base->Endpoints[i].Ready) std::atomic<uint32_t>(0);
+		}
+
+		AsPromiseBridge* Result = new(asAllocMem(sizeof(AsPromiseBridge))) AsPromiseBridge(Base, Bytes);
+		for (uint32_t i = 0; i < Capacity; i++)
+		{
+			Slot* Target = new(Result->GetSlot(i)) Slot();
+			Target->State.store(Free, std::memory_order_relaxed);
+			Target->Next.store(i + 1 < Capacity ? i + 2 : 0, std::memory_order_relaxed);
+		}
+		new(&Base->Free) std::atomic<uint64_t>(1);
+		std::atomic_thread_fence(std::memory_order_release);
+		Base->Magic = 0x50524f4d;
+		return Result;
+	}
+	/* Map a named region created by another process */
+	static AsPromiseBridge* Open(const char* Name)
+	{
+		PROMISE_ASSERT(Name != nullptr, "name should not be null");
+		int Fd = shm_open(Name, O_RDWR, 0600);
+		if (Fd < 0)
+			return nullptr;
+
+		struct stat Info;
+		void* Address = MAP_FAILED;
+		if (fstat(Fd, &Info) == 0 && (size_t)Info.st_size >= sizeof(Header))
+			Address = mmap(nullptr, (size_t)Info.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, Fd, 0);
+		close(Fd);
+		if (Address == MAP_FAILED)
+			return nullptr;
+
+		Header* Base = (Header*)Address;
+		if (Base->Magic != 0x50524f4d || Base->Size != (uint64_t)Info.st_size)
+		{
+			munmap(Address, (size_t)Info.st_size);
+			return nullptr;
+		}
+
+		return new(asAllocMem(sizeof(AsPromiseBridge))) AsPromiseBridge(Base, (size_t)Info.st_size);
+	}
+	/* Unmap region */
+	static void Destroy(AsPromiseBridge* Bridge)
+	{
+		Bridge->~AsPromiseBridge();
+		asFreeMem((void*)Bridge);
+	}
+	/* Remove name of a region, mapped regions stay valid */
+	static void Unlink(const char* Name)
+	{
+		shm_unlink(Name);
+	}
+	/* Size of primitive type by AngelScript type id, these ids are the same in every engine */
+	static uint32_t GetPrimitiveSize(int TypeId)
+	{
+		switch (TypeId)
+		{
+			case asTYPEID_BOOL:
+			case asTYPEID_INT8:
+			case asTYPEID_UINT8:
+				return 1;
+			case asTYPEID_INT16:
+			case asTYPEID_UINT16:
+				return 2;
+			case asTYPEID_INT32:
+			case asTYPEID_UINT32:
+			case asTYPEID_FLOAT:
+				return 4;
+			case asTYPEID_INT64:
+			case asTYPEID_UINT64:
+			case asTYPEID_DOUBLE:
+				return 8;
+			default:
+				PROMISE_ASSERT(TypeId == asTYPEID_VOID, "only primitive values can cross process boundary");
+				return 0;
+		}
+	}
+};
+
+/*
+	Receiving side of a bridge in one process, local promises are paired with
+	slots and settled by a watcher thread that sleeps on endpoint's doorbell
+*/
+template <typename Executor>
+class AsBridgeEndpoint
+{
+private:
+	typedef AsBasicPromise<Executor> Promise;
+
+private:
+	std::vector<Promise*> Waiting;
+	std::mutex Mutex;
+	std::thread Watcher;
+	std::atomic<bool> Active;
+	AsPromiseBridge* Bridge;
+	asIScriptEngine* Engine;
+	uint32_t Id;
+
+public:
+	AsBridgeEndpoint(AsPromiseBridge* NewBridge, uint32_t NewId, asIScriptEngine* NewEngine) : Waiting(NewBridge->GetCapacity(), nullptr), Active(true), Bridge(NewBridge), Engine(NewEngine), Id(NewId)
+	{
+		PROMISE_ASSERT(Id < PROMISE_BRIDGE_ENDPOINTS, "invalid endpoint");
+		Watcher = std::thread(&AsBridgeEndpoint::Watch, this);
+	}
+	AsBridgeEndpoint(const AsBridgeEndpoint&) = delete;
+	AsBridgeEndpoint& operator= (const AsBridgeEndpoint&) = delete;
+	~AsBridgeEndpoint()
+	{
+		Active = false;
+		Bridge->Wake(Id);
+		Watcher.join();
+
+		/*
+			Promises that are still pending would never be settled, they are rejected with ECANCELED,
+			their slots stay allocated as remote side may still write to them
+		*/
+		for (auto*& Future : Waiting)
+		{
+			if (Future != nullptr)
+			{
+				Future->RejectCode(ECANCELED);
+				Future->Release();
+			}
+			Future = nullptr;
+		}
+	}
+	/* Create a promise settled by remote process, slot index should be passed to settler, null if bridge is full */
+	Promise* Expect(uint32_t* Slot, asIScriptContext* Context = asGetActiveContext())
+	{
+		PROMISE_ASSERT(Slot != nullptr, "slot should not be null");
+		if (!Bridge->Allocate(Id, Slot))
+			return nullptr;
+
+		Promise* Future = Promise::Create(Context);
+		Future->AddRef();
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Waiting[*Slot] = Future;
+		return Future;
+	}
+	/* Settle promises of all collected slots, called by watcher */
+	size_t Dispatch()
+	{
+		size_t Count = 0;
+		uint32_t Next = Bridge->Collect(Id);
+		while (Next != 0)
+		{
+			uint32_t Index = Next - 1;
+			AsPromiseBridge::Slot* Target = Bridge->GetSlot(Index);
+			Next = Target->Next.load(std::memory_order_relaxed);
+
+			std::unique_lock<std::mutex> Unique(Mutex);
+			Promise* Future = Waiting[Index];
+			Waiting[Index] = nullptr;
+			Unique.unlock();
+			if (Future != nullptr)
+			{
+				Settle(Future, Target);
+				Future->Release();
+			}
+
+			Bridge->Release(Index);
+			++Count;
+		}
+		return Count;
+	}
+
+private:
+	void Settle(Promise* Future, AsPromiseBridge::Slot* Target)
+	{
+		uint32_t Status = Target->State.load(std::memory_order_acquire);
+		if (Status == AsPromiseBridge::Rejected)
+			Future->RejectCode(Target->ErrorCode);
+		else if (Target->TypeId == AsPromiseBridge::Bytes)
+		{
+#ifdef SCRIPTARRAY_H
+			CScriptArray* Data = AsCreateByteArray(Engine, Target->Size);
+			if (Target->Size > 0)
+				memcpy(Data->GetBuffer(), AsPromiseBridge::GetPayload(Target), Target->Size);
+			Future->Store((void*)&Data, Data->GetArrayTypeId() | asTYPEID_OBJHANDLE);
+			Data->Release();
+#else
+			PROMISE_ASSERT(false, "byte payloads require scriptarray add-on");
+			Future->RejectCode(EPROTONOSUPPORT);
+#endif
+		}
+		else if (Target->TypeId == asTYPEID_VOID)
+			Future->StoreVoid();
+		else
+			Future->Store(&Target->Value, Target->TypeId);
+	}
+	void Watch()
+	{
+		while (Active)
+		{
+			uint32_t Seen = Bridge->GetDoorbell(Id);
+			if (!Dispatch() && Active)
+				Bridge->Wait(Id, Seen, 1000);
+		}
+		asThreadCleanup();
+	}
+};
+#endif
+#if PROMISE_CACHE
+#include <chrono>
+#include <list>
+#include <string>
+#include <unordered_map>
+/*
+	Single-flight cache of promise results keyed by string, concurrent misses
+	on one key share one load, fulfilled values are kept for a lifetime within
+	LRU bound, rejected loads are not cached, every caller receives it's own
+	promise so each awaiting context is resumed
+*/
+template <typename Executor>
+class AsAsyncCache
+{
+private:
+	typedef AsBasicPromise<Executor> Promise;
+
+private:
+	struct Entry
+	{
+		Promise* Source;
+		uint64_t Expires;
+		std::list<std::string>::iterator Order;
+	};
+	struct Shard
+	{
+		std::unordered_map<std::string, Entry> Entries;
+		std::list<std::string> Order;
+		std::mutex Update;
+	};
+
+private:
+	Shard Shards[PROMISE_CACHE_SHARDS];
+	asITypeInfo* Type;
+	std::atomic<uint32_t> RefCount;
+	std::atomic<bool> Marked;
+	size_t Capacity;
+	uint64_t Lifetime;
+
+public:
+	/* Thread safe release */
+	void Release()
+	{
+		Marked = false;
+		PROMISE_ASSERT(RefCount > 0, "cache is already released");
+		if (!--RefCount)
+		{
+			ReleaseReferences(nullptr);
+			this->~AsAsyncCache();
+			asFreeMem((void*)this);
+		}
+	}
+	/* Thread safe add reference */
+	void AddRef()
+	{
+		Marked = false;
+		++RefCount;
+	}
+	/* For garbage collector to detect references */
+	void EnumReferences(asIScriptEngine* Engine)
+	{
+		for (auto& Base : Shards)
+		{
+			std::unique_lock<std::mutex> Unique(Base.Update);
+			for (auto& Item : Base.Entries)
+				Engine->GCEnumCallback(Item.second.Source);
 		}
-		else
+	}
+	/* For garbage collector to release references */
+	void ReleaseReferences(asIScriptEngine*)
+	{
+		Clear();
+	}
+	void MarkRef()
+	{
+		Marked = true;
+	}
+	bool IsRefMarked()
+	{
+		return Marked;
+	}
+	uint32_t GetRefCount()
+	{
+		return RefCount;
+	}
+	/*
+		Derive a promise for cached or in-flight value of key, loader is called
+		only on miss, it should return a referenced promise or null to reject
+	*/
+	Promise* GetOrLoad(const std::string& Key, const std::function<Promise*()>& Loader, asIScriptContext* Context = asGetActiveContext())
+	{
+		Shard& Base = GetShard(Key);
+		std::vector<Promise*> Evicted;
+		std::unique_lock<std::mutex> Unique(Base.Update);
+		Promise* Source = Find(Base, Key, Evicted);
+		if (Source != nullptr)
 		{
-			int Size1 = Engine->GetSizeOfPrimitiveType(Value.TypeId);
-			int Size2 = Engine->GetSizeOfPrimitiveType(RefTypeId);
-			PROMISE_ASSERT(Size1 == Size2, "cannot map incompatible primitive types");
+			Unique.unlock();
+			Discard(Evicted);
+			return Derive(Source, Context);
+		}
 
-			if (Size1 == Size2)
+		Source = Promise::Create(Context);
+		Insert(Base, Key, Source, Evicted);
+		Unique.unlock();
+		Discard(Evicted);
+
+		Source->AddRef();
+		Promise* Result = Derive(Source, Context);
+		Promise* Load = Loader();
+		if (Load != nullptr)
+		{
+			Load->Attach([Source](Promise* Load)
 			{
-				memcpy(RefPointer, &Value.Integer, Size1);
-				return true;
-			}
+				Load->Propagate(Source);
+				Source->Release();
+			});
+			Load->Release();
 		}
-
-		return false;
+		else
+		{
+			Source->RejectCode(PROMISE_CACHE_ERROR);
+			Source->Release();
+		}
+		return Result;
 	}
-	/* Thread safe retrieve function, also non-blocking, another syntax is used */
-	void* Retrieve()
+	/* Script version, loader is executed as nested call and should not suspend */
+	Promise* GetOrLoadScript(const std::string& Key, asIScriptFunction* Loader)
 	{
-		RetrieveVoid();
-		if (Value.TypeId == PROMISE_NULLID)
-			return nullptr;
+		PROMISE_ASSERT(Loader != nullptr, "loader should not be null");
+		Promise* Result = GetOrLoad(Key, [&Key, Loader]() { return Load(Key, Loader); });
+		Loader->Release();
+		return Result;
+	}
+	/* Check if key has a fulfilled or in-flight value */
+	bool Contains(const std::string& Key)
+	{
+		Shard& Base = GetShard(Key);
+		std::vector<Promise*> Evicted;
+		std::unique_lock<std::mutex> Unique(Base.Update);
+		Promise* Source = Find(Base, Key, Evicted);
+		Unique.unlock();
+		Discard(Evicted);
+		if (!Source)
+			return false;
 
-		if (Value.TypeId & asTYPEID_OBJHANDLE)
-			return &Value.Object;
-		else if (Value.TypeId & asTYPEID_MASK_OBJECT)
-			return Value.Object;
-		else if (Value.TypeId <= asTYPEID_DOUBLE || Value.TypeId & asTYPEID_MASK_SEQNBR)
-			return &Value.Integer;
+		Source->Release();
+		return true;
+	}
+	/* Forget the key, in-flight load still settles promises derived before */
+	void Remove(const std::string& Key)
+	{
+		Shard& Base = GetShard(Key);
+		std::vector<Promise*> Evicted;
+		std::unique_lock<std::mutex> Unique(Base.Update);
+		auto It = Base.Entries.find(Key);
+		if (It != Base.Entries.end())
+			Erase(Base, It, Evicted);
+		Unique.unlock();
+		Discard(Evicted);
+	}
+	void Clear()
+	{
+		std::vector<Promise*> Evicted;
+		for (auto& Base : Shards)
+		{
+			std::unique_lock<std::mutex> Unique(Base.Update);
+			for (auto& Item : Base.Entries)
+				Evicted.push_back(Item.second.Source);
+			Base.Entries.clear();
+			Base.Order.clear();
+		}
+		Discard(Evicted);
+	}
+	uint32_t GetSize()
+	{
+		size_t Size = 0;
+		for (auto& Base : Shards)
+		{
+			std::unique_lock<std::mutex> Unique(Base.Update);
+			Size += Base.Entries.size();
+		}
+		return (uint32_t)Size;
+	}
 
-		return nullptr;
+private:
+	AsAsyncCache(asITypeInfo* NewType, uint32_t NewCapacity, uint32_t NewLifetime) noexcept : Type(NewType), RefCount(1), Marked(false), Capacity(1), Lifetime(NewLifetime)
+	{
+		if (NewCapacity > PROMISE_CACHE_SHARDS)
+			Capacity = NewCapacity / PROMISE_CACHE_SHARDS;
+		Type->AddRef();
+		if (Type->GetFlags() & asOBJ_GC)
+			Type->GetEngine()->NotifyGarbageCollectorOfNewObject(this, Type);
 	}
-	/* Thread safe retrieve function */
-	void RetrieveVoid()
+	~AsAsyncCache()
 	{
-		std::unique_lock<std::mutex> Unique(Update);
-		asIScriptContext* ThisContext = asGetActiveContext();
-		if (ThisContext != nullptr && IsPending())
-			ThisContext->SetException("promise is still pending");
+		Type->Release();
 	}
-	/* Can be used to check if promise is still pending */
-	bool IsPending()
+	Shard& GetShard(const std::string& Key)
 	{
-		return Value.TypeId == PROMISE_NULLID;
+		return Shards[std::hash<std::string>()(Key) % PROMISE_CACHE_SHARDS];
 	}
-	/*
-		This function should be called before retrieving the value
-		from promise, it will either suspend current context and add
-		reference to this promise if it is still pending or do nothing
-		if promise was already settled
-	*/
-	AsBasicPromise* YieldIf()
+	/* Lookup live entry and mark it as most recent, returned promise is referenced, must be called under lock */
+	Promise* Find(Shard& Base, const std::string& Key, std::vector<Promise*>& Evicted)
 	{
-		std::unique_lock<std::mutex> Unique(Update);
-		if (Value.TypeId == PROMISE_NULLID && Context != nullptr && Context->Suspend() >= 0)
-			Context->SetUserData(this, PROMISE_USERID);
+		auto It = Base.Entries.find(Key);
+		if (It == Base.Entries.end())
+			return nullptr;
 
-		return this;
+		Entry& Next = It->second;
+		if (Next.Expires > 0 && Next.Expires <= AsGetTimestamp<std::chrono::milliseconds>())
+		{
+			Erase(Base, It, Evicted);
+			return nullptr;
+		}
+
+		Base.Order.splice(Base.Order.begin(), Base.Order, Next.Order);
+		Next.Source->AddRef();
+		return Next.Source;
 	}
 	/*
-		This function can be used to await for promise
-		within C++ code (blocking style)
+		Insert in-flight entry and evict least recent settled ones over the bound,
+		in-flight entries are skipped so their concurrent misses still share one
+		load, shard may exceed the bound by count of loads in flight, must be
+		called under lock
 	*/
-	AsBasicPromise* WaitIf()
+	void Insert(Shard& Base, const std::string& Key, Promise* Source, std::vector<Promise*>& Evicted)
 	{
-		if (!IsPending())
-			return this;
+		auto Next = Base.Order.end();
+		while (Base.Entries.size() >= Capacity && Next != Base.Order.begin())
+		{
+			auto It = Base.Entries.find(*--Next);
+			if (It->second.Source->IsPending())
+				continue;
 
-		std::unique_lock<std::mutex> Unique(Update);
-#if PROMISE_CALLBACKS
-		if (IsPending())
+			++Next;
+			Erase(Base, It, Evicted);
+		}
+
+		Base.Order.push_front(Key);
+		Base.Entries[Key] = { Source, 0, Base.Order.begin() };
+		Source->AddRef();
+		AddRef();
+		Source->Attach([this, Key](Promise* Source)
+		{
+			OnSettle(Key, Source);
+			Release();
+		});
+	}
+	void Erase(Shard& Base, typename std::unordered_map<std::string, Entry>::iterator It, std::vector<Promise*>& Evicted)
+	{
+		Evicted.push_back(It->second.Source);
+		Base.Order.erase(It->second.Order);
+		Base.Entries.erase(It);
+	}
+	/* Start lifetime of fulfilled value or forget rejected one */
+	void OnSettle(const std::string& Key, Promise* Source)
+	{
+		Shard& Base = GetShard(Key);
+		std::vector<Promise*> Evicted;
+		std::unique_lock<std::mutex> Unique(Base.Update);
+		auto It = Base.Entries.find(Key);
+		if (It == Base.Entries.end() || It->second.Source != Source)
+			return;
+
+		if (Source->IsFailed())
+			Erase(Base, It, Evicted);
+		else if (Lifetime > 0)
+			It->second.Expires = AsGetTimestamp<std::chrono::milliseconds>() + Lifetime;
+		Unique.unlock();
+		Discard(Evicted);
+	}
+	/* Release promises outside of shard lock, releasing values may execute script code */
+	void Discard(std::vector<Promise*>& Evicted)
+	{
+		for (auto* Source : Evicted)
+			Source->Release();
+	}
+
+private:
+	/* Per caller promise, settled in place when source is already settled */
+	static Promise* Derive(Promise* Source, asIScriptContext* Context)
+	{
+		Promise* Target = Promise::Create(Context);
+		Target->AddRef();
+		Source->Attach([Target](Promise* Source)
+		{
+			Source->Propagate(Target);
+			Target->Release();
+		});
+		Source->Release();
+		return Target;
+	}
+	static Promise* Load(const std::string& Key, asIScriptFunction* Loader)
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		asIScriptEngine* Engine = Loader->GetEngine();
+		bool Nested = Context != nullptr && Context->GetState() == asEXECUTION_ACTIVE;
+		if (Nested)
+			PROMISE_CHECK(Context->PushState());
+		else
+			Context = Engine->RequestContext();
+
+		Promise* Result = nullptr;
+		PROMISE_CHECK(Context->Prepare(Loader));
+		PROMISE_CHECK(Context->SetArgObject(0, (void*)&Key));
+		if (Context->Execute() == asEXECUTION_FINISHED)
 		{
-			std::condition_variable Ready;
-			Callbacks.Native = [&Ready](AsBasicPromise<Executor>*) { Ready.notify_all(); };
-			Ready.wait(Unique, [this]() { return !IsPending(); });
+			Result = (Promise*)Context->GetReturnObject();
+			if (Result != nullptr)
+				Result->AddRef();
 		}
-#else
-		if (IsPending())
-			Ready.wait(Unique, [this]() { return !IsPending(); });
-#endif
-		return this;
+
+		if (Nested)
+			PROMISE_CHECK(Context->PopState());
+		else
+			Engine->ReturnContext(Context);
+		return Result;
+	}
+	/* Subtype is validated by promise<T> of methods, cache always holds promises so it is always collected */
+	static bool TemplateCallback(asITypeInfo*, bool& DontGarbageCollect)
+	{
+		DontGarbageCollect = false;
+		return true;
+	}
+
+public:
+	static AsAsyncCache* Create(asITypeInfo* Type, uint32_t Capacity, uint32_t Lifetime)
+	{
+		return new(asAllocMem(sizeof(AsAsyncCache))) AsAsyncCache(Type, Capacity, Lifetime);
 	}
+	/*
+		Interface registration, requires string add-on, capacity
+		is a bound of entries, lifetime is in milliseconds (zero
+		keeps fulfilled values until evicted)
+	*/
+	static void Register(asIScriptEngine* Engine)
+	{
+		using Type = AsAsyncCache<Executor>;
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_CACHENAME "<class T>", 0, asOBJ_REF | asOBJ_GC | asOBJ_TEMPLATE));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_FACTORY, PROMISE_CACHENAME "<T>@ f(int&in, uint = 1024, uint = 0)", asFUNCTION(Type::Create), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_TEMPLATE_CALLBACK, "bool f(int&in, bool&out)", asFUNCTION(Type::TemplateCallback), asCALL_CDECL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_SETGCFLAG, "void f()", asMETHOD(Type, MarkRef), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_GETGCFLAG, "bool f()", asMETHOD(Type, IsRefMarked), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_GETREFCOUNT, "int f()", asMETHOD(Type, GetRefCount), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_ENUMREFS, "void f(int&in)", asMETHOD(Type, EnumReferences), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_CACHENAME "<T>", asBEHAVE_RELEASEREFS, "void f(int&in)", asMETHOD(Type, ReleaseReferences), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterFuncdef(PROMISE_TYPENAME "<T>@ " PROMISE_CACHENAME "<T>::loader(const string&in)"));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_CACHENAME "<T>", PROMISE_TYPENAME "<T>@ get_or_load(const string&in, loader@)", asMETHOD(Type, GetOrLoadScript), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_CACHENAME "<T>", "bool contains(const string&in)", asMETHOD(Type, Contains), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_CACHENAME "<T>", "void remove(const string&in)", asMETHOD(Type, Remove), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_CACHENAME "<T>", "void clear()", asMETHOD(Type, Clear), asCALL_THISCALL));
+		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_CACHENAME "<T>", "uint size()", asMETHOD(Type, GetSize), asCALL_THISCALL));
+	}
+};
+
+/* Register async cache type, promise interface and string type should be registered first */
+template <typename Executor>
+static void AsRegisterCache(asIScriptEngine* Engine)
+{
+	AsAsyncCache<Executor>::Register(Engine);
+}
+#endif
+#if PROMISE_GC_SCHEDULER
+#include <algorithm>
+#include <chrono>
+#include <string>
+/*
+	Incremental garbage collection driven by event loop, automatic collection
+	of engine is turned off and loop hands it's slack time to <Idle> where
+	single steps run until time budget is spent or current cycle completes,
+	full cycle is forced only after tracked objects grew by a threshold since
+	the last completed cycle, so survivors do not force a cycle every tick
+*/
+class AsGarbageScheduler
+{
+public:
+	/* Work done by one idle call */
+	struct Tick
+	{
+		uint64_t Elapsed = 0;
+		uint32_t Steps = 0;
+		uint32_t Objects = 0;
+		uint32_t Destroyed = 0;
+		uint32_t Detected = 0;
+		bool Completed = false;
+		bool Forced = false;
+	};
+	/* Totals of all idle calls, written by loop thread and readable from any thread */
+	struct Counters
+	{
+		std::atomic<uint64_t> Ticks = { 0 };
+		std::atomic<uint64_t> Steps = { 0 };
+		std::atomic<uint64_t> Cycles = { 0 };
+		std::atomic<uint64_t> Forced = { 0 };
+		std::atomic<uint64_t> Destroyed = { 0 };
+		std::atomic<uint64_t> Detected = { 0 };
+		std::atomic<uint64_t> Elapsed = { 0 };
+		std::atomic<uint64_t> Objects = { 0 };
+	};
 
 private:
+	Counters Values;
+	Tick Last;
+	asIScriptEngine* Engine;
+	asPWORD Automatic;
+	uint64_t Budget;
+	uint32_t Threshold;
+	uint32_t Baseline;
+
+public:
+	AsGarbageScheduler(asIScriptEngine* NewEngine, uint64_t BudgetUs = PROMISE_GC_BUDGET, uint32_t ObjectsThreshold = PROMISE_GC_THRESHOLD) : Engine(NewEngine), Budget(BudgetUs), Threshold(ObjectsThreshold), Baseline(0)
+	{
+		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+		Automatic = Engine->GetEngineProperty(asEP_AUTO_GARBAGE_COLLECT);
+		Engine->SetEngineProperty(asEP_AUTO_GARBAGE_COLLECT, false);
+	}
+	AsGarbageScheduler(const AsGarbageScheduler&) = delete;
+	AsGarbageScheduler& operator= (const AsGarbageScheduler&) = delete;
+	~AsGarbageScheduler()
+	{
+		Engine->SetEngineProperty(asEP_AUTO_GARBAGE_COLLECT, Automatic);
+	}
 	/*
-		Construct a promise, notify GC, set value to none,
-		grab a reference to script context
+		Spend up to min(slack, budget) microseconds on incremental steps, should be
+		called by thread that runs the loop when it has nothing to do or when tick
+		finished early, returns what was done
 	*/
-	AsBasicPromise(asIScriptContext* NewContext) noexcept : Engine(nullptr), Context(NewContext), RefCount(1), RefMark(0)
+	const Tick& Idle(uint64_t SlackUs = std::numeric_limits<uint64_t>::max())
 	{
-		PROMISE_ASSERT(Context != nullptr, "context should not be null");
-		Engine = Context->GetEngine();
-		Engine->NotifyGarbageCollectorOfNewObject(this, Engine->GetTypeInfoByName(PROMISE_TYPENAME));
-		Clean();
+		asUINT Objects = 0, Destroyed = 0, Detected = 0, NewDestroyed = 0;
+		Engine->GetGCStatistics(&Objects, &Destroyed, &Detected, nullptr, &NewDestroyed);
+
+		uint64_t Start = AsGetTimestamp(), Deadline = Start + std::min(SlackUs, Budget);
+		Last = Tick();
+		Baseline = std::min<uint32_t>(Baseline, Objects);
+		if (Threshold > 0 && (uint64_t)Objects >= (uint64_t)Baseline + Threshold)
+		{
+			Last.Forced = Last.Completed = Engine->GarbageCollect(asGC_FULL_CYCLE) >= 0;
+			++Last.Steps;
+		}
+		else
+		{
+			/* At least one step is done so that long ticks do not starve collector completely */
+			do
+			{
+				int Status = Engine->GarbageCollect(asGC_ONE_STEP);
+				++Last.Steps;
+				if (Status <= 0)
+				{
+					Last.Completed = Status == 0;
+					break;
+				}
+			} while (AsGetTimestamp() < Deadline);
+		}
+
+		asUINT NextDestroyed = 0, NextDetected = 0, NextNewDestroyed = 0;
+		Engine->GetGCStatistics(&Last.Objects, &NextDestroyed, &NextDetected, nullptr, &NextNewDestroyed);
+		Last.Destroyed = (NextDestroyed - Destroyed) + (NextNewDestroyed - NewDestroyed);
+		Last.Detected = NextDetected - Detected;
+		Last.Elapsed = AsGetTimestamp() - Start;
+		if (Last.Completed)
+			Baseline = Last.Objects;
+
+		Values.Ticks.fetch_add(1, std::memory_order_relaxed);
+		Values.Steps.fetch_add(Last.Steps, std::memory_order_relaxed);
+		Values.Destroyed.fetch_add(Last.Destroyed, std::memory_order_relaxed);
+		Values.Detected.fetch_add(Last.Detected, std::memory_order_relaxed);
+		Values.Elapsed.fetch_add(Last.Elapsed, std::memory_order_relaxed);
+		Values.Objects.store(Last.Objects, std::memory_order_relaxed);
+		if (Last.Completed)
+			Values.Cycles.fetch_add(1, std::memory_order_relaxed);
+		if (Last.Forced)
+			Values.Forced.fetch_add(1, std::memory_order_relaxed);
+		return Last;
 	}
-	/* Reset value to none */
-	void Clean()
+	/* Change time budget of one idle call */
+	void SetBudget(uint64_t BudgetUs)
 	{
-		memset(&Value, 0, sizeof(Value));
-		Value.TypeId = PROMISE_NULLID;
+		Budget = BudgetUs;
+	}
+	/* Change growth of tracked objects since last completed cycle that forces full cycle, zero disables forcing */
+	void SetThreshold(uint32_t ObjectsThreshold)
+	{
+		Threshold = ObjectsThreshold;
+	}
+	/* Get result of latest idle call, loop thread only */
+	const Tick& GetLastTick() const
+	{
+		return Last;
+	}
+	/* Get totals, safe to read from any thread */
+	Counters& GetCounters()
+	{
+		return Values;
 	}
+	/* Export totals in plain text exposition format (prometheus compatible) */
+	std::string Export()
+	{
+		std::string Result;
+		AsExportSample(Result, "promise_gc_ticks_total", Values.Ticks.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_gc_steps_total", Values.Steps.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_gc_cycles_total", Values.Cycles.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_gc_forced_total", Values.Forced.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_gc_destroyed_total", Values.Destroyed.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_gc_detected_total", Values.Detected.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_gc_elapsed_us_total", Values.Elapsed.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_gc_objects", Values.Objects.load(std::memory_order_relaxed));
+		return Result;
+	}
+};
+#endif
+#if PROMISE_ENGINES
+#include <algorithm>
+#include <chrono>
+#include <string>
+/*
+	Pool of script engines initialized ahead of time by a background thread,
+	setup function registers interfaces and builds modules that every tenant
+	shares, engines given back are cleaned of tenant modules and garbage so
+	that next tenant skips setup completely
+*/
+class AsEnginePool
+{
+public:
+	/* Totals of pool, relaxed atomics readable from any thread */
+	struct Counters
+	{
+		std::atomic<uint64_t> Created = { 0 };
+		std::atomic<uint64_t> Warm = { 0 };
+		std::atomic<uint64_t> Cold = { 0 };
+		std::atomic<uint64_t> Recycled = { 0 };
+		std::atomic<uint64_t> Destroyed = { 0 };
+		std::atomic<uint64_t> SetupTime = { 0 };
+		std::atomic<uint64_t> SavedTime = { 0 };
+	};
+
+private:
+	/* Per engine record kept in engine user data and freed with engine */
+	struct Record
+	{
+		std::vector<std::string> Modules;
+		uint64_t SetupTime = 0;
+	};
+
+private:
+	std::function<void(asIScriptEngine*)> Setup;
+	std::vector<asIScriptEngine*> Idle;
+	std::condition_variable Condition;
+	std::mutex Mutex;
+	std::thread Thread;
+	Counters Values;
+	size_t Capacity;
+	size_t Warming;
+	bool Active;
 
 public:
-	/* AsBasicPromise creation function, for use within C++ */
-	static AsBasicPromise* Create(asIScriptContext* Context = asGetActiveContext())
+	/* Should be constructed on main thread, engines are created by background thread */
+	AsEnginePool(std::function<void(asIScriptEngine*)>&& NewSetup, size_t NewCapacity = PROMISE_ENGINES_IDLE) : Setup(std::move(NewSetup)), Capacity(NewCapacity), Warming(0), Active(true)
 	{
-		return new(asAllocMem(sizeof(AsBasicPromise))) AsBasicPromise(Context);
+		PROMISE_ASSERT(Setup != nullptr, "engine setup function should not be null");
+		PROMISE_CHECK(asPrepareMultithread());
+		Thread = std::thread(&AsEnginePool::Loop, this);
 	}
-	/* AsBasicPromise creation function, for use within AngelScript */
-	static AsBasicPromise* CreateFactory(void* _Ref, int TypeId)
+	AsEnginePool(const AsEnginePool&) = delete;
+	AsEnginePool& operator= (const AsEnginePool&) = delete;
+	~AsEnginePool()
 	{
-		AsBasicPromise* Future = new(asAllocMem(sizeof(AsBasicPromise))) AsBasicPromise(asGetActiveContext());
-		if (TypeId != asTYPEID_VOID)
-			Future->Store(_Ref, TypeId);
-
-		return Future;
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Active = false;
+		Condition.notify_all();
+		Unique.unlock();
+		Thread.join();
+		for (auto* Engine : Idle)
+			Destroy(Engine);
+		asUnprepareMultithread();
 	}
-	/* AsBasicPromise creation function, for use within AngelScript (void promise) */
-	static AsBasicPromise* CreateFactoryVoid(void* _Ref, int TypeId)
+	/* Take ready engine or set up a new one in place if none is ready */
+	asIScriptEngine* Acquire()
 	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (!Idle.empty())
+		{
+			asIScriptEngine* Engine = Idle.back();
+			Idle.pop_back();
+			Condition.notify_all();
+			Unique.unlock();
+			Values.Warm.fetch_add(1, std::memory_order_relaxed);
+			Values.SavedTime.fetch_add(GetRecord(Engine)->SetupTime, std::memory_order_relaxed);
+			return Engine;
+		}
+
+		Condition.notify_all();
+		Unique.unlock();
+		Values.Cold.fetch_add(1, std::memory_order_relaxed);
 		return Create();
 	}
 	/*
-		Interface registration, note: promise<void> is not supported,
-		instead use promise_v when internal datatype is not intended,
-		promise will be an object handle with GC behaviours, default
-		constructed promise will be pending otherwise early settled
+		Give engine back, modules built after setup are discarded and full garbage
+		cycle is run, engine is destroyed if pool is full or reuse is not wanted
+		(e.g. tenant changed engine properties or registered own interfaces)
 	*/
-	static void Register(asIScriptEngine* Engine)
+	void Release(asIScriptEngine* Engine, bool Reuse = true)
 	{
-		using Type = AsBasicPromise<Executor>;
 		PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
-		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_TYPENAME "<class T>", 0, asOBJ_REF | asOBJ_GC | asOBJ_TEMPLATE));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_FACTORY, PROMISE_TYPENAME "<T>@ f(?&in)", asFUNCTION(Type::CreateFactory), asCALL_CDECL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_TEMPLATE_CALLBACK, "bool f(int&in, bool&out)", asFUNCTION(Type::TemplateCallback), asCALL_CDECL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_SETGCFLAG, "void f()", asMETHOD(Type, MarkRef), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_GETGCFLAG, "bool f()", asMETHOD(Type, IsRefMarked), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_GETREFCOUNT, "int f()", asMETHOD(Type, GetRefCount), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_ENUMREFS, "void f(int&in)", asMETHOD(Type, EnumReferences), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME "<T>", asBEHAVE_RELEASEREFS, "void f(int&in)", asMETHOD(Type, ReleaseReferences), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "void " PROMISE_WRAP "(?&in)", asMETHODPR(Type, Store, (void*, int), void), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "T& " PROMISE_UNWRAP "()", asMETHODPR(Type, Retrieve, (), void*), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", PROMISE_TYPENAME "<T>@+ " PROMISE_YIELD "()", asMETHOD(Type, YieldIf), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "bool " PROMISE_PENDING "()", asMETHOD(Type, IsPending), asCALL_THISCALL));
-#if PROMISE_CALLBACKS
-		PROMISE_CHECK(Engine->RegisterFuncdef("void " PROMISE_TYPENAME "<T>::" PROMISE_EVENT "(promise<T>@+)"));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME "<T>", "void " PROMISE_WHEN "(" PROMISE_EVENT "@)", asMETHODPR(Type, When, (asIScriptFunction*), void), asCALL_THISCALL));
-#endif
-		PROMISE_CHECK(Engine->RegisterObjectType(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, 0, asOBJ_REF | asOBJ_GC));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_FACTORY, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ f()", asFUNCTION(Type::CreateFactoryVoid), asCALL_CDECL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_ADDREF, "void f()", asMETHOD(Type, AddRef), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_RELEASE, "void f()", asMETHOD(Type, Release), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_SETGCFLAG, "void f()", asMETHOD(Type, MarkRef), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_GETGCFLAG, "bool f()", asMETHOD(Type, IsRefMarked), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_GETREFCOUNT, "int f()", asMETHOD(Type, GetRefCount), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_ENUMREFS, "void f(int&in)", asMETHOD(Type, EnumReferences), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectBehaviour(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, asBEHAVE_RELEASEREFS, "void f(int&in)", asMETHOD(Type, ReleaseReferences), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_WRAP "()", asMETHODPR(Type, StoreVoid, (), void), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_UNWRAP "()", asMETHODPR(Type, RetrieveVoid, (), void), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@+ " PROMISE_YIELD "()", asMETHOD(Type, YieldIf), asCALL_THISCALL));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "bool " PROMISE_PENDING "()", asMETHOD(Type, IsPending), asCALL_THISCALL));
-#if PROMISE_CALLBACKS
-		PROMISE_CHECK(Engine->RegisterFuncdef("void " PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "::" PROMISE_EVENT "(promise_v@+)"));
-		PROMISE_CHECK(Engine->RegisterObjectMethod(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX, "void " PROMISE_WHEN "(" PROMISE_EVENT "@)", asMETHODPR(Type, When, (asIScriptFunction*), void), asCALL_THISCALL));
-#endif
+		if (Reuse)
+			Reuse = Reset(Engine);
+
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Reuse && Active && Idle.size() < Capacity)
+		{
+			Idle.push_back(Engine);
+			Unique.unlock();
+			Values.Recycled.fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+
+		Unique.unlock();
+		Destroy(Engine);
+	}
+	/* Get count of ready engines */
+	size_t GetIdle()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		return Idle.size();
+	}
+	/* Get microseconds spent on setup of engine created by this pool */
+	uint64_t GetSetupTime(asIScriptEngine* Engine)
+	{
+		Record* Base = GetRecord(Engine);
+		return Base != nullptr ? Base->SetupTime : 0;
+	}
+	/* Get totals, safe to read from any thread */
+	Counters& GetCounters()
+	{
+		return Values;
+	}
+	/* Export totals in plain text exposition format (prometheus compatible) */
+	std::string Export()
+	{
+		std::string Result;
+		AsExportSample(Result, "promise_engines_created_total", Values.Created.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_engines_warm_total", Values.Warm.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_engines_cold_total", Values.Cold.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_engines_recycled_total", Values.Recycled.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_engines_destroyed_total", Values.Destroyed.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_engines_setup_us_total", Values.SetupTime.load(std::memory_order_relaxed));
+		AsExportSample(Result, "promise_engines_saved_us_total", Values.SavedTime.load(std::memory_order_relaxed));
+		return Result;
 	}
 
 private:
-	/* Template callback function for compiler, copy-paste from <array> class */
-	static bool TemplateCallback(asITypeInfo* Info, bool& DontGarbageCollect)
+	/* Keep pool filled up to capacity, one engine is set up at a time */
+	void Loop()
 	{
-		int TypeId = Info->GetSubTypeId();
-		if (TypeId == asTYPEID_VOID)
-			return false;
-
-		if ((TypeId & asTYPEID_MASK_OBJECT) && !(TypeId & asTYPEID_OBJHANDLE))
+		std::unique_lock<std::mutex> Unique(Mutex);
+		while (true)
 		{
-			asIScriptEngine* Engine = Info->GetEngine();
-			asITypeInfo* SubType = Engine->GetTypeInfoById(TypeId);
-			asQWORD Flags = SubType->GetFlags();
+			Condition.wait(Unique, [this]() { return !Active || Idle.size() + Warming < Capacity; });
+			if (!Active)
+				break;
 
-			if ((Flags & asOBJ_VALUE) && !(Flags & asOBJ_POD))
-			{
-				bool Found = false;
-				for (size_t i = 0; i < SubType->GetBehaviourCount(); i++)
-				{
-					asEBehaviours Behaviour;
-					asIScriptFunction* Func = SubType->GetBehaviourByIndex((int)i, &Behaviour);
-					if (Behaviour != asBEHAVE_CONSTRUCT)
-						continue;
+			++Warming;
+			Unique.unlock();
+			asIScriptEngine* Engine = Create();
+			Unique.lock();
+			--Warming;
+			if (Active && Idle.size() < Capacity)
+				Idle.push_back(Engine);
+			else
+				Destroy(Engine);
+		}
+		Unique.unlock();
+		asThreadCleanup();
+	}
+	asIScriptEngine* Create()
+	{
+		uint64_t Start = AsGetTimestamp();
+		asIScriptEngine* Engine = asCreateScriptEngine();
+		PROMISE_ASSERT(Engine != nullptr, "cannot create script engine");
+		Setup(Engine);
 
-					if (Func->GetParamCount() == 0)
-					{
-						Found = true;
-						break;
-					}
-				}
+		Record* Base = new(asAllocMem(sizeof(Record))) Record();
+		for (asUINT i = 0; i < Engine->GetModuleCount(); i++)
+			Base->Modules.push_back(Engine->GetModuleByIndex(i)->GetName());
+		Base->SetupTime = AsGetTimestamp() - Start;
+		Engine->SetUserData((void*)Base, PROMISE_USERID + 9);
+		Engine->SetEngineUserDataCleanupCallback(&AsEnginePool::Cleanup, PROMISE_USERID + 9);
+		Values.Created.fetch_add(1, std::memory_order_relaxed);
+		Values.SetupTime.fetch_add(Base->SetupTime, std::memory_order_relaxed);
+		return Engine;
+	}
+	/* Discard tenant modules, reinitialize globals of setup modules and collect everything tenant left behind */
+	bool Reset(asIScriptEngine* Engine)
+	{
+		Record* Base = GetRecord(Engine);
+		if (Base == nullptr)
+			return false;
 
-				if (!Found)
-				{
-					Engine->WriteMessage(PROMISE_TYPENAME, 0, 0, asMSGTYPE_ERROR, "The subtype has no default constructor");
-					return false;
-				}
-			}
-			else if ((Flags & asOBJ_REF))
-			{
-				bool Found = false;
-				if (!Engine->GetEngineProperty(asEP_DISALLOW_VALUE_ASSIGN_FOR_REF_TYPE))
-				{
-					for (size_t i = 0; i < SubType->GetFactoryCount(); i++)
-					{
-						asIScriptFunction* Function = SubType->GetFactoryByIndex((int)i);
-						if (Function->GetParamCount() == 0)
-						{
-							Found = true;
-							break;
-						}
-					}
-				}
+		std::vector<std::string> Names;
+		for (asUINT i = 0; i < Engine->GetModuleCount(); i++)
+		{
+			const char* Name = Engine->GetModuleByIndex(i)->GetName();
+			if (std::find(Base->Modules.begin(), Base->Modules.end(), Name) == Base->Modules.end())
+				Names.push_back(Name);
+		}
 
-				if (!Found)
-				{
-					Engine->WriteMessage(PROMISE_TYPENAME, 0, 0, asMSGTYPE_ERROR, "The subtype has no default factory");
-					return false;
-				}
-			}
+		for (auto& Name : Names)
+			Engine->DiscardModule(Name.c_str());
 
-			if (!(Flags & asOBJ_GC))
-				DontGarbageCollect = true;
-		}
-		else if (!(TypeId & asTYPEID_OBJHANDLE))
+		for (auto& Name : Base->Modules)
 		{
-			DontGarbageCollect = true;
+			asIScriptModule* Module = Engine->GetModule(Name.c_str(), asGM_ONLY_IF_EXISTS);
+			if (!Module || Module->ResetGlobalVars() < 0)
+				return false;
 		}
-		else
-		{
-			asITypeInfo* SubType = Info->GetEngine()->GetTypeInfoById(TypeId);
-			asQWORD Flags = SubType->GetFlags();
+		return Engine->GarbageCollect(asGC_FULL_CYCLE) >= 0;
+	}
+	void Destroy(asIScriptEngine* Engine)
+	{
+		Engine->ShutDownAndRelease();
+		Values.Destroyed.fetch_add(1, std::memory_order_relaxed);
+	}
 
-			if (!(Flags & asOBJ_GC))
-			{
-				if ((Flags & asOBJ_SCRIPT_OBJECT))
-				{
-					if ((Flags & asOBJ_NOINHERIT))
-						DontGarbageCollect = true;
-				}
-				else
-					DontGarbageCollect = true;
-			}
+private:
+	static Record* GetRecord(asIScriptEngine* Engine)
+	{
+		return (Record*)Engine->GetUserData(PROMISE_USERID + 9);
+	}
+	static void Cleanup(asIScriptEngine* Engine)
+	{
+		Record* Base = GetRecord(Engine);
+		if (Base != nullptr)
+		{
+			Base->~Record();
+			asFreeMem((void*)Base);
 		}
-
-		return true;
 	}
 };
-
+#endif
 #ifndef AS_PROMISE_NO_GENERATOR
 /*
 	A fast and minimal code generator function for custom syntax of promise class,
@@ -734,6 +7063,9 @@ static char* AsGeneratePromiseEntrypoints(const char* Text, size_t* InoutTextSiz
 }
 #endif
 #ifndef AS_PROMISE_NO_DEFAULTS
+#include <algorithm>
+#include <deque>
+#include <queue>
 /*
 	Basic promise settle executor, will
 	resume context at thread that has
@@ -742,7 +7074,8 @@ static char* AsGeneratePromiseEntrypoints(const char* Text, size_t* InoutTextSiz
 struct AsDirectExecutor
 {
 	/* Called after suspend, this method will probably be inlined anyways */
-	inline void operator()(AsBasicPromise<AsDirectExecutor>* Promise, asIScriptContext* Context)
+	template <typename Promise>
+	inline void operator()(Promise*, asIScriptContext* Context)
 	{
 		/*
 			Context should be suspended at this moment but if for
@@ -750,10 +7083,11 @@ struct AsDirectExecutor
 			then user is responsible for this task to be properly queued or
 			exception should thrown if possible
 		*/
-		Context->Execute();
+		AsExecuteContext(Context);
 	}
 	/* Called after suspend, for callback execution */
-	inline void operator()(AsBasicPromise<AsDirectExecutor>* Promise, asIScriptContext* Context, asIScriptFunction* Callback)
+	template <typename Promise>
+	inline void operator()(Promise* Target, asIScriptContext* Context, asIScriptFunction* Callback)
 	{
 		/*
 			Callback control flow:
@@ -762,10 +7096,10 @@ struct AsDirectExecutor
 				Otherwise: execute on current context
 		*/
 		asEContextState State = Context->GetState();
-		auto Execute = [&Promise, &Context, &Callback]()
+		auto Execute = [&Target, &Context, &Callback]()
 		{
 			PROMISE_CHECK(Context->Prepare(Callback));
-			PROMISE_CHECK(Context->SetArgObject(0, Promise));
+			PROMISE_CHECK(Context->SetArgObject(0, Target));
 			Context->Execute();
 		};
 		if (State == asEXECUTION_ACTIVE)
@@ -814,15 +7148,375 @@ struct AsReactiveExecutor
 		PROMISE_ASSERT(!Callback || *Callback, "invalid reactive callback");
 		Context->SetUserData((void*)Callback, 1022);
 	}
+	/* Fallback for contexts without own callback (pooled contexts of spawned functions) */
+	static void SetCallback(asIScriptEngine* Engine, ReactiveCallback* Callback)
+	{
+		PROMISE_ASSERT(!Callback || *Callback, "invalid reactive callback");
+		Engine->SetUserData((void*)Callback, 1022);
+	}
 	static ReactiveCallback& GetCallback(asIScriptContext* Context)
 	{
 		ReactiveCallback* Callback = (ReactiveCallback*)Context->GetUserData(1022);
+		if (!Callback)
+			Callback = (ReactiveCallback*)Context->GetEngine()->GetUserData(1022);
+		PROMISE_ASSERT(Callback != nullptr, "missing reactive callback on context");
+		return *Callback;
+	}
+};
+
+/*
+	Deterministic virtual time source, time jumps to the next timer
+	whenever nothing is runnable, ready tasks run in FIFO order (zero
+	seed) or in order picked by seeded generator, so same seed and
+	same inputs always produce same schedule
+*/
+class AsVirtualClock
+{
+private:
+	struct Timer
+	{
+		uint64_t Deadline;
+		uint64_t Order;
+		uint64_t Sequence;
+		std::function<void()> Callback;
+
+		bool operator> (const Timer& Other) const
+		{
+			if (Deadline != Other.Deadline)
+				return Deadline > Other.Deadline;
+			return Order != Other.Order ? Order > Other.Order : Sequence > Other.Sequence;
+		}
+	};
+
+private:
+	std::priority_queue<Timer, std::vector<Timer>, std::greater<Timer>> Timers;
+	std::deque<std::function<void()>> Ready;
+	std::mutex Mutex;
+	uint64_t Time;
+	uint64_t Sequence;
+	uint64_t Seed;
+	uint64_t State;
+
+public:
+	AsVirtualClock(uint64_t NewSeed = 0) : Time(0), Sequence(0), Seed(NewSeed), State(NewSeed)
+	{
+	}
+	AsVirtualClock(const AsVirtualClock&) = delete;
+	AsVirtualClock& operator= (const AsVirtualClock&) = delete;
+	/* Queue a task that is runnable now, thread safe */
+	void Post(std::function<void()>&& Callback)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Ready.push_back(std::move(Callback));
+	}
+	/* Queue a task that becomes runnable after virtual delay, thread safe */
+	void Schedule(uint64_t DelayMs, std::function<void()>&& Callback)
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		Timers.push(Timer { Time + DelayMs, Seed ? Random() : 0, Sequence++, std::move(Callback) });
+	}
+	/* Run one ready task, advance time to the next timer if there are none, false when idle */
+	bool Step(uint64_t Until = std::numeric_limits<uint64_t>::max())
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Ready.empty() && !Advance(Until))
+			return false;
+
+		size_t Index = Seed && Ready.size() > 1 ? (size_t)(Random() % Ready.size()) : 0;
+		std::function<void()> Callback = std::move(Ready[Index]);
+		if (Index > 0)
+			Ready[Index] = std::move(Ready.front());
+		Ready.pop_front();
+		Unique.unlock();
+		Callback();
+		return true;
+	}
+	/* Run until idle or until virtual time would pass the limit, returns count of executed tasks */
+	size_t Run(uint64_t Until = std::numeric_limits<uint64_t>::max())
+	{
+		size_t Executed = 0;
+		while (Step(Until))
+			++Executed;
+
+		std::unique_lock<std::mutex> Unique(Mutex);
+		if (Until != std::numeric_limits<uint64_t>::max() && Time < Until)
+			Time = Until;
+		return Executed;
+	}
+	bool HasWork()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		return !Ready.empty() || !Timers.empty();
+	}
+	/* Virtual time in milliseconds */
+	uint64_t GetTime()
+	{
+		std::unique_lock<std::mutex> Unique(Mutex);
+		return Time;
+	}
+
+private:
+	/* Jump to the earliest deadline and make every timer of that moment ready, must be called under lock */
+	bool Advance(uint64_t Until)
+	{
+		if (Timers.empty() || Timers.top().Deadline > Until)
+			return false;
+
+		Time = std::max(Time, Timers.top().Deadline);
+		while (!Timers.empty() && Timers.top().Deadline <= Time)
+		{
+			Ready.push_back(std::move(const_cast<Timer&>(Timers.top()).Callback));
+			Timers.pop();
+		}
+		return true;
+	}
+	/* Splitmix64, must be called under lock */
+	uint64_t Random()
+	{
+		uint64_t Result = (State += 0x9e3779b97f4a7c15ull);
+		Result = (Result ^ (Result >> 30)) * 0xbf58476d1ce4e5b9ull;
+		Result = (Result ^ (Result >> 27)) * 0x94d049bb133111ebull;
+		return Result ^ (Result >> 31);
+	}
+
+public:
+	/* Bind clock to engine, clock should outlive the engine */
+	static void Attach(asIScriptEngine* Engine, AsVirtualClock* Clock)
+	{
+		Engine->SetUserData((void*)Clock, PROMISE_USERID + 8);
+	}
+	static AsVirtualClock* Get(asIScriptEngine* Engine)
+	{
+		AsVirtualClock* Clock = (AsVirtualClock*)Engine->GetUserData(PROMISE_USERID + 8);
+		PROMISE_ASSERT(Clock != nullptr, "virtual clock is not attached to engine");
+		return Clock;
+	}
+	/* Script timer, settled when virtual time reaches the deadline */
+	template <typename Executor>
+	static AsBasicPromise<Executor>* Sleep(uint64_t DelayMs)
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		PROMISE_ASSERT(Context != nullptr, "sleep should be called from script context");
+		AsBasicPromise<Executor>* Future = AsBasicPromise<Executor>::Create(Context);
+		Future->AddRef();
+		Get(Context->GetEngine())->Schedule(DelayMs, [Future]()
+		{
+			Future->StoreVoid();
+			Future->Release();
+		});
+		return Future;
+	}
+	static asQWORD GetTimeScript()
+	{
+		asIScriptContext* Context = asGetActiveContext();
+		PROMISE_ASSERT(Context != nullptr, "virtual time should be queried from script context");
+		return (asQWORD)Get(Context->GetEngine())->GetTime();
+	}
+};
+
+/*
+	Executor that queues resumptions and callbacks into virtual
+	clock of the engine, all of them run on thread that steps
+	the clock, use with single stepping thread for determinism
+*/
+struct AsVirtualTimeExecutor
+{
+	/* Called after suspend, resumption is queued as ready task */
+	template <typename Promise>
+	inline void operator()(Promise*, asIScriptContext* Context)
+	{
+		AsVirtualClock::Get(Context->GetEngine())->Post([Context]()
+		{
+			AsExecuteContext(Context);
+		});
+	}
+	/* Called after suspend, for callback execution, calling context may be gone by then so callback gets it's own */
+	template <typename Promise>
+	inline void operator()(Promise* Target, asIScriptContext* Context, asIScriptFunction* Callback)
+	{
+		asIScriptEngine* Engine = Context->GetEngine();
+		Target->AddRef();
+		AsVirtualClock::Get(Engine)->Post([Target, Engine, Callback]()
+		{
+			asIScriptContext* Context = Engine->RequestContext();
+			PROMISE_CHECK(Context->Prepare(Callback));
+			PROMISE_CHECK(Context->SetArgObject(0, Target));
+			Context->Execute();
+			Engine->ReturnContext(Context);
+			AsClearCallback(Callback);
+			Target->Release();
+		});
+	}
+};
+
+/* Attach virtual clock and register it's timer functions, promise interface should be registered first */
+template <typename Executor>
+static void AsRegisterVirtualTime(asIScriptEngine* Engine, AsVirtualClock* Clock)
+{
+	PROMISE_ASSERT(Engine != nullptr, "script engine should not be null");
+	PROMISE_ASSERT(Clock != nullptr, "virtual clock should not be null");
+	AsVirtualClock::Attach(Engine, Clock);
+	PROMISE_CHECK(Engine->RegisterGlobalFunction(PROMISE_TYPENAME PROMISE_VOIDPOSTFIX "@ " PROMISE_SLEEP "(uint64)", asFUNCTION(AsVirtualClock::Sleep<Executor>), asCALL_CDECL));
+	PROMISE_CHECK(Engine->RegisterGlobalFunction("uint64 " PROMISE_VIRTUALTIME "()", asFUNCTION(AsVirtualClock::GetTimeScript), asCALL_CDECL));
+}
+
+/*
+	Executor that resumes each promise through a policy
+	chosen by promise tag, tag is inherited from context
+	(or engine) at creation so one engine may resume some
+	promises in-place and hand others to a queue or a pool.
+*/
+struct AsPolymorphicExecutor
+{
+	typedef AsBasicPromise<AsPolymorphicExecutor> Promise;
+	typedef std::function<void(Promise*, asIScriptFunction*)> ReactiveCallback;
+	typedef void(*ResumeCallback)(Promise*, asIScriptContext*);
+	typedef void(*ExecuteCallback)(Promise*, asIScriptContext*, asIScriptFunction*);
+
+	/* Built-in policies, tags starting from custom are free for user policies */
+	enum Policies : uint8_t
+	{
+		Direct = 0,
+		Reactive = 1,
+		Pooled = 2,
+		Custom = 3
+	};
+	struct Policy
+	{
+		ResumeCallback Resume;
+		ExecuteCallback Execute;
+	};
+
+	/* Called after suspend, costs one indirect call */
+	inline void operator()(Promise* Target, asIScriptContext* Context)
+	{
+		GetPolicies()[Target->GetExecutorTag()].Resume(Target, Context);
+	}
+	/* Called after suspend, for callback execution */
+	inline void operator()(Promise* Target, asIScriptContext* Context, asIScriptFunction* Callback)
+	{
+		GetPolicies()[Target->GetExecutorTag()].Execute(Target, Context, Callback);
+	}
+	/* Register custom policy, should be done before any promise may use it's tag */
+	static void SetPolicy(uint8_t Tag, ResumeCallback Resume, ExecuteCallback Execute)
+	{
+		PROMISE_ASSERT(Tag >= Custom && Tag < PROMISE_EXECUTOR_POLICIES, "built-in policies cannot be replaced");
+		PROMISE_ASSERT(Resume != nullptr && Execute != nullptr, "policy should have both callbacks");
+		GetPolicies()[Tag] = { Resume, Execute };
+	}
+	/* Policy of promises created within this context */
+	static void SetPolicy(asIScriptContext* Context, uint8_t Tag)
+	{
+		PROMISE_ASSERT(HasPolicy(Tag), "executor policy is not registered");
+		Context->SetUserData((void*)(uintptr_t)(Tag + 1), PROMISE_USERID + 6);
+	}
+	/* Fallback for contexts without own policy (pooled contexts of spawned functions) */
+	static void SetPolicy(asIScriptEngine* Engine, uint8_t Tag)
+	{
+		PROMISE_ASSERT(HasPolicy(Tag), "executor policy is not registered");
+		Engine->SetUserData((void*)(uintptr_t)(Tag + 1), PROMISE_USERID + 6);
+	}
+	static uint8_t GetPolicy(asIScriptContext* Context)
+	{
+		uintptr_t Tag = (uintptr_t)Context->GetUserData(PROMISE_USERID + 6);
+		if (!Tag)
+			Tag = (uintptr_t)Context->GetEngine()->GetUserData(PROMISE_USERID + 6);
+		return Tag > 0 ? (uint8_t)(Tag - 1) : (uint8_t)Direct;
+	}
+	static bool HasPolicy(uint8_t Tag)
+	{
+		return Tag < PROMISE_EXECUTOR_POLICIES && GetPolicies()[Tag].Resume != nullptr;
+	}
+	/* Queue used by reactive policy, same rules as for reactive executor */
+	static void SetCallback(asIScriptContext* Context, ReactiveCallback* Callback)
+	{
+		PROMISE_ASSERT(!Callback || *Callback, "invalid reactive callback");
+		Context->SetUserData((void*)Callback, PROMISE_USERID + 7);
+	}
+	static void SetCallback(asIScriptEngine* Engine, ReactiveCallback* Callback)
+	{
+		PROMISE_ASSERT(!Callback || *Callback, "invalid reactive callback");
+		Engine->SetUserData((void*)Callback, PROMISE_USERID + 7);
+	}
+	static ReactiveCallback& GetCallback(asIScriptContext* Context)
+	{
+		ReactiveCallback* Callback = (ReactiveCallback*)Context->GetUserData(PROMISE_USERID + 7);
+		if (!Callback)
+			Callback = (ReactiveCallback*)Context->GetEngine()->GetUserData(PROMISE_USERID + 7);
 		PROMISE_ASSERT(Callback != nullptr, "missing reactive callback on context");
 		return *Callback;
 	}
+
+private:
+	/* Constant initialized, no guard on the resume path */
+	static Policy* GetPolicies()
+	{
+		static Policy Table[PROMISE_EXECUTOR_POLICIES] =
+		{
+			{ &ResumeDirect, &ExecuteDirect },
+			{ &ResumeReactive, &ExecuteReactive },
+#ifndef AS_PROMISE_NO_BINDINGS
+			{ &ResumePooled, &ExecutePooled }
+#endif
+		};
+		return Table;
+	}
+	static void ResumeDirect(Promise* Target, asIScriptContext* Context)
+	{
+		AsDirectExecutor()(Target, Context);
+	}
+	static void ExecuteDirect(Promise* Target, asIScriptContext* Context, asIScriptFunction* Callback)
+	{
+		AsDirectExecutor()(Target, Context, Callback);
+	}
+	static void ResumeReactive(Promise* Target, asIScriptContext* Context)
+	{
+		GetCallback(Context)(Target, nullptr);
+	}
+	static void ExecuteReactive(Promise* Target, asIScriptContext* Context, asIScriptFunction* Callback)
+	{
+		GetCallback(Context)(Target, Callback);
+	}
+#ifndef AS_PROMISE_NO_BINDINGS
+	/* Context is resumed by a worker of blocking pool */
+	static void ResumePooled(Promise*, asIScriptContext* Context)
+	{
+		AsBlockingPool::Get().Enqueue([Context]()
+		{
+			AsExecuteContext(Context);
+		});
+	}
+	/* Callback is executed by a worker of blocking pool on a separate context */
+	static void ExecutePooled(Promise* Target, asIScriptContext* Context, asIScriptFunction* Callback)
+	{
+		asIScriptEngine* Engine = Context->GetEngine();
+		Target->AddRef();
+		AsBlockingPool::Get().Enqueue([Target, Engine, Callback]()
+		{
+			asIScriptContext* Context = Engine->RequestContext();
+			PROMISE_CHECK(Context->Prepare(Callback));
+			PROMISE_CHECK(Context->SetArgObject(0, Target));
+			Context->Execute();
+			Engine->ReturnContext(Context);
+			AsClearCallback(Callback);
+			Target->Release();
+		});
+	}
+#endif
+};
+
+template <>
+struct AsExecutorTag<AsPolymorphicExecutor>
+{
+	static uint8_t Get(asIScriptContext* Context)
+	{
+		return AsPolymorphicExecutor::GetPolicy(Context);
+	}
 };
 
 using AsDirectPromise = AsBasicPromise<AsDirectExecutor>;
 using AsReactivePromise = AsBasicPromise<AsReactiveExecutor>;
+using AsPolymorphicPromise = AsBasicPromise<AsPolymorphicExecutor>;
+using AsVirtualTimePromise = AsBasicPromise<AsVirtualTimeExecutor>;
 #endif
 #endif
\ No newline at end of file
@@ -0,0 +1,102 @@
+#include "test.hpp"
+#include <vector>
+
+static std::vector<AsDirectPromise*> Pending;
+static std::vector<asIScriptContext*> Contexts;
+static std::vector<int> Order;
+
+static AsDirectPromise* CreatePending()
+{
+	AsDirectPromise* Promise = AsDirectPromise::Create();
+	Promise->AddRef();
+	Pending.push_back(Promise);
+	return Promise;
+}
+static void Mark(int Value)
+{
+	Order.push_back(Value);
+}
+static void Start(asIScriptModule* Module, int Id)
+{
+	asIScriptEngine* Engine = Module->GetEngine();
+	asIScriptContext* Context = Engine->RequestContext();
+	TEST_CHECK(Context->Prepare(Module->GetFunctionByDecl("void main(int)")) >= 0);
+	TEST_CHECK(Context->SetArgDWord(0, (asDWORD)Id) >= 0);
+	Contexts.push_back(Context);
+	AsExecuteContext(Context);
+}
+static void Settle(size_t Index)
+{
+	int Value = 0;
+	Pending[Index]->Store(&Value, asTYPEID_INT32);
+}
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending()", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	TEST_CHECK(Engine->RegisterGlobalFunction("void mark(int)", asFUNCTION(Mark), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, "void main(int id) { co_await pending(); mark(id); }");
+
+	AsPromiseAdmission Admission(2, 0, 1);
+	Admission.Attach(Engine);
+
+	/* Deferred work counts against limit before it runs, so burst is queued */
+	std::vector<std::function<void()>> Deferred;
+	Admission.SetScheduler([&Deferred](std::function<void()>&& Task) { Deferred.push_back(std::move(Task)); });
+	TEST_CHECK(Admission.Admit([Module]() { Start(Module, 1); }));
+	TEST_CHECK(Admission.Admit([Module]() { Start(Module, 2); }));
+	TEST_CHECK(Admission.Admit([Module]() { Start(Module, 3); }));
+	TEST_CHECK(!Admission.Admit([Module]() { Start(Module, 4); }));
+	AsPromiseAdmission::Gauges Gauges = Admission.GetGauges();
+	TEST_CHECK(Gauges.Running == 2 && Gauges.Queued == 1 && Gauges.Rejected == 1);
+
+	/* Tasks that return suspended move from running to suspended */
+	Admission.SetScheduler([](std::function<void()>&& Task) { Task(); });
+	for (auto& Task : Deferred)
+		Task();
+	Gauges = Admission.GetGauges();
+	TEST_CHECK(Gauges.Running == 0 && Gauges.Suspended == 2 && Gauges.Queued == 1);
+	TEST_CHECK(Gauges.SuspendedBytes > 0);
+
+	/* Resumed context runs before queued work takes it's place */
+	Settle(0);
+	TEST_CHECK(Contexts[0]->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(Order.size() == 1 && Order[0] == 1);
+	TEST_CHECK(Contexts.size() == 3 && Contexts[2]->GetState() == asEXECUTION_SUSPENDED);
+	Gauges = Admission.GetGauges();
+	TEST_CHECK(Gauges.Suspended == 2 && Gauges.Queued == 0);
+
+	/* Aborted context is released from accounting when returned to pool */
+	TEST_CHECK(Contexts[1]->Abort() >= 0);
+	Engine->ReturnContext(Contexts[1]);
+	Contexts[1] = nullptr;
+	Gauges = Admission.GetGauges();
+	TEST_CHECK(Gauges.Suspended == 1);
+
+	/* Bytes are released exactly as they were counted */
+	Settle(2);
+	TEST_CHECK(Order.size() == 2 && Order[1] == 3);
+	Gauges = Admission.GetGauges();
+	TEST_CHECK(Gauges.Suspended == 0 && Gauges.SuspendedBytes == 0);
+
+	/* Work admitted without queueing counts as running until completed */
+	TEST_CHECK(Admission.TryAdmit() && Admission.TryAdmit());
+	TEST_CHECK(!Admission.TryAdmit());
+	Gauges = Admission.GetGauges();
+	TEST_CHECK(Gauges.Running == 2 && Gauges.Rejected == 2);
+	Admission.Complete();
+	Admission.Complete();
+	TEST_CHECK(Admission.GetGauges().Running == 0);
+
+	for (auto* Context : Contexts)
+	{
+		if (Context != nullptr)
+			Engine->ReturnContext(Context);
+	}
+	for (auto* Promise : Pending)
+		Promise->Release();
+	Admission.Detach();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
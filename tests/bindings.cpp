@@ -0,0 +1,68 @@
+#include "test.hpp"
+#include <stdexcept>
+#include <vector>
+
+/* Pool that runs work only when asked, so test stays on one thread */
+struct ManualPool
+{
+	std::vector<std::function<void()>> Tasks;
+
+	void Enqueue(std::function<void()>&& Task)
+	{
+		Tasks.push_back(std::move(Task));
+	}
+	void Run()
+	{
+		std::vector<std::function<void()>> Current = std::move(Tasks);
+		for (auto& Task : Current)
+			Task();
+	}
+};
+
+static const char* Code =
+	"int sum = 0;\n"
+	"int code = 0;\n"
+	"string text;\n"
+	"void main() {\n"
+	"  sum = co_await add(2, 3);\n"
+	"  text = co_await upper(\"abc\");\n"
+	"  promise_v@ failed = fail();\n"
+	"  co_await failed;\n"
+	"  code = failed.error_code();\n"
+	"}\n";
+
+int main()
+{
+	ManualPool Pool;
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterAsyncFunction<AsDirectExecutor>(Engine, "promise<int>@ add(int, int)", [](int32_t A, int32_t B) { return A + B; }, Pool);
+	AsRegisterAsyncFunction<AsDirectExecutor>(Engine, "promise<string>@ upper(const string&in)", [](const std::string& Text)
+	{
+		std::string Result = Text;
+		for (auto& Next : Result)
+			Next = (char)toupper(Next);
+		return Result;
+	}, Pool);
+	AsRegisterAsyncFunction<AsDirectExecutor>(Engine, "promise_v@ fail()", []() { throw std::runtime_error("failure"); }, Pool);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Every call suspends script until pool runs the callable */
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	for (int i = 0; i < 3; i++)
+	{
+		TEST_CHECK(Context->GetState() == asEXECUTION_SUSPENDED);
+		TEST_CHECK(Pool.Tasks.size() == 1);
+		Pool.Run();
+	}
+
+	/* Exception in callable rejects instead of throwing into script */
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "sum") == 5);
+	TEST_CHECK(TestGlobal<std::string>(Module, "text") == "ABC");
+	TEST_CHECK(TestGlobal<int>(Module, "code") == PROMISE_BINDING_ERROR);
+
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
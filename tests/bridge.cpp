@@ -0,0 +1,108 @@
+#include "test.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <sys/wait.h>
+
+static AsBridgeEndpoint<AsDirectExecutor>* Endpoint = nullptr;
+static uint32_t Slots[3] = { 0 };
+static std::atomic<bool> Done(false);
+
+static AsDirectPromise* Expect(uint32_t Index)
+{
+	AsDirectPromise* Future = Endpoint->Expect(&Slots[Index]);
+	TEST_CHECK(Future != nullptr);
+	return Future;
+}
+static AsDirectPromise* ExpectNumber()
+{
+	return Expect(0);
+}
+static AsDirectPromise* ExpectBytes()
+{
+	return Expect(1);
+}
+static AsDirectPromise* ExpectFailure()
+{
+	return Expect(2);
+}
+static void SetDone()
+{
+	Done = true;
+}
+
+static const char* Code =
+	"int64 number = 0;\n"
+	"uint bytes = 0;\n"
+	"uint8 first = 0;\n"
+	"int code = 0;\n"
+	"void main() {\n"
+	"  promise<int64>@ a = expect_number();\n"
+	"  promise<array<uint8>@>@ b = expect_bytes();\n"
+	"  promise_v@ c = expect_failure();\n"
+	"  number = co_await a;\n"
+	"  array<uint8>@ data = co_await b;\n"
+	"  bytes = data.length();\n"
+	"  first = data[0];\n"
+	"  co_await c;\n"
+	"  code = c.error_code();\n"
+	"  done();\n"
+	"}\n";
+
+int main()
+{
+	TEST_CHECK(asPrepareMultithread() >= 0);
+	AsPromiseBridge* Bridge = AsPromiseBridge::Create(nullptr, 16, 64);
+	TEST_CHECK(Bridge != nullptr);
+
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	Endpoint = new AsBridgeEndpoint<AsDirectExecutor>(Bridge, 0, Engine);
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int64>@ expect_number()", asFUNCTION(ExpectNumber), asCALL_CDECL) >= 0);
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<array<uint8>@>@ expect_bytes()", asFUNCTION(ExpectBytes), asCALL_CDECL) >= 0);
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise_v@ expect_failure()", asFUNCTION(ExpectFailure), asCALL_CDECL) >= 0);
+	TEST_CHECK(Engine->RegisterGlobalFunction("void done()", asFUNCTION(SetDone), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+
+	/* Child process inherits anonymous region and settles every slot */
+	pid_t Child = fork();
+	TEST_CHECK(Child >= 0);
+	if (Child == 0)
+	{
+		int64_t Value = 42;
+		bool Settled = Bridge->Fulfill(Slots[0], &Value, asTYPEID_INT64);
+		Settled = Bridge->FulfillBytes(Slots[1], "xyz", 3) && Settled;
+		Settled = Bridge->Reject(Slots[2], 77) && Settled;
+		_exit(Settled ? 0 : 1);
+	}
+
+	int Exit = 0;
+	TEST_CHECK(waitpid(Child, &Exit, 0) == Child);
+	TEST_CHECK(WIFEXITED(Exit) && WEXITSTATUS(Exit) == 0);
+
+	/* Watcher thread of parent resumes script */
+	for (int i = 0; i < 500 && !Done; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	TEST_CHECK(Done);
+	while (Context->GetState() == asEXECUTION_ACTIVE)
+		std::this_thread::yield();
+	TEST_CHECK(TestGlobal<asINT64>(Module, "number") == 42);
+	TEST_CHECK(TestGlobal<asUINT>(Module, "bytes") == 3);
+	TEST_CHECK(TestGlobal<asBYTE>(Module, "first") == 'x');
+	TEST_CHECK(TestGlobal<int>(Module, "code") == 77);
+
+	/* Promise still pending when endpoint is destroyed is cancelled */
+	uint32_t Slot = 0;
+	AsDirectPromise* Orphan = Endpoint->Expect(&Slot, Context);
+	TEST_CHECK(Orphan != nullptr && Orphan->IsPending());
+	delete Endpoint;
+	TEST_CHECK(Orphan->IsFailed() && Orphan->GetErrorCode() == ECANCELED);
+	Orphan->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	AsPromiseBridge::Destroy(Bridge);
+	return 0;
+}
@@ -0,0 +1,83 @@
+#include "test.hpp"
+#include <functional>
+#include <string>
+#include <vector>
+
+typedef AsAsyncCache<AsDirectExecutor> Cache;
+
+static std::vector<AsDirectPromise*> Loads;
+static asIScriptContext* Context = nullptr;
+
+static AsDirectPromise* Load()
+{
+	AsDirectPromise* Result = AsDirectPromise::Create(Context);
+	Result->AddRef();
+	Loads.push_back(Result);
+	return Result;
+}
+static int Unwrap(AsDirectPromise* Result)
+{
+	TEST_CHECK(!Result->IsPending() && !Result->IsFailed());
+	int Value = *(int*)Result->Retrieve();
+	Result->Release();
+	return Value;
+}
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterCache<AsDirectExecutor>(Engine);
+	Context = Engine->CreateContext();
+
+	/* Keys of one shard, each shard keeps one entry */
+	std::vector<std::string> Keys;
+	size_t Shard = std::hash<std::string>()("key") % PROMISE_CACHE_SHARDS;
+	for (int i = 0; Keys.size() < 3; i++)
+	{
+		std::string Key = "key" + std::to_string(i);
+		if (std::hash<std::string>()(Key) % PROMISE_CACHE_SHARDS == Shard)
+			Keys.push_back(Key);
+	}
+	Cache* Base = Cache::Create(Engine->GetTypeInfoByDecl(PROMISE_CACHENAME "<int>"), 1, 0);
+
+	/* In-flight entry is not evicted by a miss of another key */
+	AsDirectPromise* First = Base->GetOrLoad(Keys[0], &Load, Context);
+	AsDirectPromise* Second = Base->GetOrLoad(Keys[1], &Load, Context);
+	TEST_CHECK(Loads.size() == 2);
+	TEST_CHECK(Base->Contains(Keys[0]) && Base->Contains(Keys[1]));
+	AsDirectPromise* Shared = Base->GetOrLoad(Keys[0], &Load, Context);
+	TEST_CHECK(Loads.size() == 2);
+
+	/* Concurrent misses are settled by one load */
+	int Value = 7;
+	Loads[0]->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(Unwrap(First) == 7);
+	TEST_CHECK(Unwrap(Shared) == 7);
+
+	/* Settled entry is evicted first, in-flight one stays */
+	AsDirectPromise* Third = Base->GetOrLoad(Keys[2], &Load, Context);
+	TEST_CHECK(Loads.size() == 3);
+	TEST_CHECK(!Base->Contains(Keys[0]));
+	TEST_CHECK(Base->Contains(Keys[1]) && Base->Contains(Keys[2]));
+	TEST_CHECK(Base->GetSize() == 2);
+
+	Value = 8;
+	Loads[1]->Store(&Value, asTYPEID_INT32);
+	Value = 9;
+	Loads[2]->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(Unwrap(Second) == 8);
+	TEST_CHECK(Unwrap(Third) == 9);
+
+	/* Bound is restored once loads settle */
+	AsDirectPromise* Fourth = Base->GetOrLoad(Keys[0], &Load, Context);
+	TEST_CHECK(Base->GetSize() == 1);
+	Loads[3]->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(Unwrap(Fourth) == 9);
+
+	for (auto* Next : Loads)
+		Next->Release();
+	Base->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
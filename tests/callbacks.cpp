@@ -0,0 +1,45 @@
+#include "test.hpp"
+
+static AsDirectPromise* Pending = nullptr;
+
+static AsDirectPromise* CreatePending()
+{
+	Pending = AsDirectPromise::Create();
+	Pending->AddRef();
+	return Pending;
+}
+
+static const char* Code =
+	"int first = 0;\n"
+	"int second = 0;\n"
+	"int early = 0;\n"
+	"void main() {\n"
+	"  promise<int>@ result = pending();\n"
+	"  result.when(function(value) { first = value.unwrap(); });\n"
+	"  result.when(function(value) { second = value.unwrap(); });\n"
+	"  promise<int>@ settled = promise<int>(5);\n"
+	"  settled.when(function(value) { early = value.unwrap(); });\n"
+	"}\n";
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending()", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Callback of settled promise runs at once, replaced callback never runs */
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "early") == 5);
+
+	int Value = 7;
+	Pending->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(TestGlobal<int>(Module, "first") == 0);
+	TEST_CHECK(TestGlobal<int>(Module, "second") == 7);
+
+	Pending->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
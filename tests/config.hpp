@@ -0,0 +1,75 @@
+/* Configuration used by tests: defaults of aspromise.hpp with every optional module enabled */
+#ifndef AS_PROMISE_TEST_CONFIG_HPP
+#define AS_PROMISE_TEST_CONFIG_HPP
+#define PROMISE_CONFIG
+#define PROMISE_TYPENAME "promise" // promise type
+#define PROMISE_VOIDPOSTFIX "_v" // promise<void> type (promise_v)
+#define PROMISE_WRAP "wrap" // promise setter function
+#define PROMISE_UNWRAP "unwrap" // promise getter function
+#define PROMISE_YIELD "yield" // promise awaiter function
+#define PROMISE_WHEN "when" // promise callback function
+#define PROMISE_EVENT "when_callback" // promise funcdef name
+#define PROMISE_PENDING "pending" // promise status checker
+#define PROMISE_REJECT "reject" // promise failure setter function
+#define PROMISE_FAILED "failed" // promise failure checker
+#define PROMISE_ERRORCODE "error_code" // promise failure code getter
+#define PROMISE_ERRORDETAIL "error_detail" // promise failure detail getter
+#define PROMISE_UNWRAPOR "unwrap_or" // promise getter function that never throws
+#define PROMISE_AWAIT "co_await" // keyword for await (C++20 coroutines one love)
+#define PROMISE_MUTEX "async_mutex" // coroutine mutex type
+#define PROMISE_SEMAPHORE "async_semaphore" // coroutine semaphore type
+#define PROMISE_EVENTTYPE "async_event" // coroutine event type
+#define PROMISE_BARRIER "async_barrier" // coroutine barrier type
+#define PROMISE_SPAWN "spawn" // concurrent script function starter
+#define PROMISE_TASKGROUP "task_group" // spawned functions group type
+#define PROMISE_SLEEP "sleep" // virtual time timer function
+#define PROMISE_VIRTUALTIME "virtual_time" // virtual time getter function
+#define PROMISE_USERID 559 // promise user data identifier (any value)
+#define PROMISE_NULLID -1 // empty promise type id
+#define PROMISE_CALLBACKS true // allow <when> listener
+#define PROMISE_MAP "map" // promise inline transform function
+#define PROMISE_THEN "then" // promise inline continuation function
+#define PROMISE_MAPEVENT "map_callback" // promise transform funcdef name
+#define PROMISE_CONTINUATION_ERROR -1 // error code of rejection caused by failed continuation
+#define PROMISE_BINDING_ERROR -2 // error code of rejection caused by exception in async native function
+#define PROMISE_SPAWN_ERROR -3 // error code of rejection caused by exception in spawned function
+#define PROMISE_CACHE_ERROR -4 // error code of rejection caused by failed cache loader
+#define PROMISE_PARALLEL_ERROR -5 // error code of rejection caused by exception in parallel callback
+#define PROMISE_TRACING true // record promise lifecycle events (compiled out by default)
+#define PROMISE_TRACE_CAPACITY 16384 // trace events kept per thread before dropping
+#define PROMISE_METRICS true // collect runtime counters and await site histograms
+#define PROMISE_METRICS_BUCKETS 32 // latency histogram buckets (log2 of microseconds)
+#define PROMISE_METRICS_SHARDS 16 // await site map shards
+#define PROMISE_ADMISSION true // track suspended contexts for admission control
+#define PROMISE_ADMISSION_FRAME_SIZE 256 // estimated bytes per suspended call frame
+#define PROMISE_REGISTRY true // keep registry of pending promises for introspection and watchdog
+#define PROMISE_REGISTRY_SHARDS 16 // registry shards (by creating thread)
+#define PROMISE_REGISTRY_CHUNK 256 // registry slots allocated at once per shard
+#define PROMISE_FIBERS true // allow native functions to await promises on pooled fiber stacks (posix ucontext)
+#define PROMISE_FIBER_STACK 262144 // usable bytes of fiber stack, guard page is added below
+#define PROMISE_FIBER_POOL 64 // idle fibers kept by fiber pool
+#define PROMISE_PARALLEL true // register parallel_for and parallel_map on blocking pool (requires scriptarray add-on)
+#define PROMISE_PARALLELFOR "parallel_for" // parallel loop function, it's callback funcdef gets <_callback> postfix
+#define PROMISE_PARALLELMAP "parallel_map" // parallel array transform method, it's callback funcdef gets <_callback> postfix
+#define PROMISE_FILES true // register async file module (requires scriptarray add-on)
+#define PROMISE_FILE "async_file" // async file handle type
+#define PROMISE_FILE_ENTRIES 256 // io_uring submission queue size
+#define PROMISE_FILE_CHUNK 4096 // first read size of files that do not report their size
+#define PROMISE_SOCKETS true // register socket module on epoll reactor (linux, requires scriptarray add-on)
+#define PROMISE_SOCKET "async_socket" // async socket type
+#define PROMISE_REACTOR_EVENTS 64 // readiness events handled per reactor wait
+#define PROMISE_PROCESSES true // register subprocess module on epoll reactor (linux, requires scriptarray and string add-ons)
+#define PROMISE_PROCESS "async_process" // streaming subprocess type
+#define PROMISE_PROCESSRESULT "process_result" // captured subprocess output type
+#define PROMISE_BRIDGE true // settle promises from other processes through shared memory (linux)
+#define PROMISE_BRIDGE_ENDPOINTS 16 // max processes receiving through one bridge region
+#define PROMISE_EXECUTOR_POLICIES 8 // resume policies of polymorphic executor
+#define PROMISE_CACHE true // register single-flight async cache (requires string add-on)
+#define PROMISE_CACHENAME "async_cache" // async cache type
+#define PROMISE_CACHE_SHARDS 16 // async cache shards, capacity is split between them
+#define PROMISE_GC_SCHEDULER true // run incremental garbage collection in event loop slack time
+#define PROMISE_GC_BUDGET 1000 // microseconds of garbage collection per idle call
+#define PROMISE_GC_THRESHOLD 65536 // tracked objects count that forces full cycle
+#define PROMISE_ENGINES true // keep pool of script engines set up ahead of time
+#define PROMISE_ENGINES_IDLE 4 // ready engines kept by engine pool
+#endif
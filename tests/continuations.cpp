@@ -0,0 +1,65 @@
+#include "test.hpp"
+
+static AsDirectPromise* Pending = nullptr;
+static int Requested = 0;
+
+static AsDirectPromise* CreatePending()
+{
+	Pending = AsDirectPromise::Create();
+	Pending->AddRef();
+	return Pending;
+}
+static asIScriptContext* RequestContext(asIScriptEngine* Engine, void*)
+{
+	++Requested;
+	return Engine->CreateContext();
+}
+static void ReturnContext(asIScriptEngine*, asIScriptContext* Context, void*)
+{
+	Context->Release();
+}
+
+static const char* Code =
+	"int result = 0;\n"
+	"bool failed = false;\n"
+	"void chain() {\n"
+	"  pending().map(function(value) { return value * 2; }).map(function(value) { return value + 1; }).then(function(value) { result = value.unwrap(); });\n"
+	"}\n"
+	"void rejected() {\n"
+	"  promise<int>@ source = promise<int>();\n"
+	"  promise_v@ done = source.map(function(value) { check(false); return value; }).then(function(value) { failed = value.failed(); });\n"
+	"  source.reject(5);\n"
+	"  check(failed && !done.failed());\n"
+	"}\n";
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending()", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	TEST_CHECK(Engine->SetContextCallbacks(&RequestContext, &ReturnContext, nullptr) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Chain is attached without suspending the context */
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void chain()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "result") == 0);
+
+	/* Host settles the source, all stages run within one dispatch on one pooled context */
+	int Value = 20;
+	Pending->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(TestGlobal<int>(Module, "result") == 41);
+	TEST_CHECK(Requested == 1);
+
+	/* Settled within script, stages are nested calls of active context */
+	Requested = 0;
+	asIScriptContext* Rejected = TestStart(Module, "void rejected()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(Requested == 0);
+
+	Rejected->Release();
+	Pending->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,70 @@
+#include "test.hpp"
+#include <condition_variable>
+#include <mutex>
+
+/* Setup of every engine after the first one waits until test opens the gate */
+struct Gate
+{
+	std::condition_variable Condition;
+	std::mutex Mutex;
+	int Setups = 0;
+	bool Open = false;
+};
+
+static void Run(asIScriptEngine* Engine, const char* Declaration)
+{
+	asIScriptFunction* Function = Engine->GetModule("shared")->GetFunctionByDecl(Declaration);
+	TEST_CHECK(Function != nullptr);
+	asIScriptContext* Context = Engine->RequestContext();
+	TEST_CHECK(Context->Prepare(Function) >= 0);
+	TEST_CHECK(Context->Execute() == asEXECUTION_FINISHED);
+	Engine->ReturnContext(Context);
+}
+
+int main()
+{
+	Gate Base;
+	AsEnginePool* Pool = new AsEnginePool([&Base](asIScriptEngine* Engine)
+	{
+		std::unique_lock<std::mutex> Unique(Base.Mutex);
+		if (Base.Setups++ > 0)
+			Base.Condition.wait(Unique, [&Base]() { return Base.Open; });
+		Unique.unlock();
+
+		TEST_CHECK(Engine->SetMessageCallback(asFUNCTION(TestLog), 0, asCALL_CDECL) >= 0);
+		RegisterStdString(Engine);
+		RegisterScriptArray(Engine, true);
+		AsBasicPromise<AsDirectExecutor>::Register(Engine);
+		TEST_CHECK(Engine->RegisterGlobalFunction("void check(bool)", asFUNCTION(TestScriptCheck), asCALL_CDECL) >= 0);
+		TestBuild(Engine, "int counter = 0; array<int>@ items = {}; void bump() { counter++; items.insertLast(counter); } void verify() { check(counter == 0 && items.length() == 0); }", "shared");
+	}, 1);
+	while (Pool->GetIdle() == 0)
+		std::this_thread::yield();
+
+	/* Tenant changes globals of setup module and builds it's own module */
+	asIScriptEngine* Engine = Pool->Acquire();
+	Run(Engine, "void bump()");
+	TestBuild(Engine, "void main() { }", "tenant");
+	Pool->Release(Engine);
+
+	/* Next tenant gets the same engine with fresh globals and without tenant module */
+	TEST_CHECK(Pool->Acquire() == Engine);
+	TEST_CHECK(Engine->GetModule("tenant", asGM_ONLY_IF_EXISTS) == nullptr);
+	Run(Engine, "void verify()");
+
+	/* Engine without setup module is not reused */
+	Engine->DiscardModule("shared");
+	Pool->Release(Engine);
+	TEST_CHECK(Pool->GetIdle() == 0);
+
+	std::unique_lock<std::mutex> Unique(Base.Mutex);
+	Base.Open = true;
+	Base.Condition.notify_all();
+	Unique.unlock();
+
+	AsEnginePool::Counters& Values = Pool->GetCounters();
+	TEST_CHECK(Values.Warm == 2 && Values.Cold == 0);
+	TEST_CHECK(Values.Recycled == 1);
+	delete Pool;
+	return 0;
+}
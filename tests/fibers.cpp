@@ -0,0 +1,90 @@
+#include "test.hpp"
+#include <vector>
+
+static std::vector<AsDirectPromise*> Gates;
+
+/* Pending promise settled by test, awaited inside of fiber */
+static AsDirectPromise* CreateGate()
+{
+	AsDirectPromise* Gate = AsDirectPromise::Create(asGetActiveContext());
+	Gate->AddRef();
+	Gates.push_back(Gate);
+	return Gate;
+}
+static int Twice(int Value)
+{
+	TEST_CHECK(AsFiber::GetCurrent() != nullptr);
+	AsDirectPromise* Gate = AsAwait(CreateGate());
+	int Result = *(int*)Gate->Retrieve() + Value * 2;
+	Gate->Release();
+	return Result;
+}
+static bool IsOnFiber()
+{
+	return AsFiber::GetCurrent() != nullptr;
+}
+static void Open(size_t Index, int Value)
+{
+	TEST_CHECK(Gates.size() > Index);
+	Gates[Index]->Store(&Value, asTYPEID_INT32);
+}
+
+static const char* Code =
+	"int first = 0;\n"
+	"int second = 0;\n"
+	"void main() {\n"
+	"  first = co_await twice(1);\n"
+	"  check(!on_fiber());\n"
+	"  second = co_await twice(2);\n"
+	"  check(!on_fiber());\n"
+	"}\n"
+	"void unmapped() {\n"
+	"  promise<int>@ result = huge(1);\n"
+	"  check(result.failed() && result.error_code() == -2);\n"
+	"}\n";
+
+int main()
+{
+	AsFiberPool Pool;
+	AsFiberPool Unmappable((size_t)1 << 60);
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("bool on_fiber()", asFUNCTION(IsOnFiber), asCALL_CDECL) >= 0);
+	AsRegisterAsyncFunction<AsDirectExecutor>(Engine, "promise<int>@ twice(int)", &Twice, Pool);
+	AsRegisterAsyncFunction<AsDirectExecutor>(Engine, "promise<int>@ huge(int)", &Twice, Unmappable);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Callable parks on pending promise, script awaits it's result */
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+	TEST_CHECK(AsFiber::GetCurrent() == nullptr);
+	TEST_CHECK(Gates.size() == 1 && Pool.GetIdle() == 0);
+
+	/*
+		Settling resumes fiber, script is resumed only after fiber returned,
+		so nested call of second binding enters a fresh fiber from plain stack
+	*/
+	Open(0, 10);
+	TEST_CHECK(AsFiber::GetCurrent() == nullptr);
+	TEST_CHECK(TestGlobal<int>(Module, "first") == 12);
+	TEST_CHECK(Context->GetState() == asEXECUTION_SUSPENDED);
+	TEST_CHECK(Gates.size() == 2 && Pool.GetIdle() == 0);
+
+	Open(1, 20);
+	TEST_CHECK(AsFiber::GetCurrent() == nullptr);
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "second") == 24);
+	TEST_CHECK(Pool.GetIdle() == 1);
+	Context->Release();
+
+	/* Stack that cannot be mapped rejects the call instead of crashing */
+	Context = TestStart(Module, "void unmapped()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(Unmappable.GetFailures() == 1 && Unmappable.GetIdle() == 0);
+
+	for (auto* Gate : Gates)
+		Gate->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,61 @@
+#include "test.hpp"
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+static std::atomic<bool> Done(false);
+
+static void SetDone()
+{
+	Done = true;
+}
+
+static const char* Code =
+	"void main() {\n"
+	"  array<uint8> data = { 104, 105 };\n"
+	"  co_await write_file(\"files.bin\", data);\n"
+	"  async_file@ file = open(\"files.bin\", \"a\");\n"
+	"  check(file !is null);\n"
+	"  uint written = co_await file.write_at(0, data);\n"
+	"  check(written == 2);\n"
+	"  @file = null;\n"
+	"  array<uint8> large(65536, 7);\n"
+	"  promise_v@ copied = write_file(\"files2.bin\", large);\n"
+	"  large.resize(1);\n"
+	"  large.insertLast(1);\n"
+	"  co_await copied;\n"
+	"  array<uint8>@ copy = co_await read_file(\"files2.bin\");\n"
+	"  check(copy.length() == 65536 && copy[65535] == 7);\n"
+	"  array<uint8>@ all = co_await read_file(\"files.bin\");\n"
+	"  check(all.length() == 4 && all[0] == 104 && all[2] == 104);\n"
+	"  array<uint8>@ status = co_await read_file(\"/proc/self/status\");\n"
+	"  check(status.length() > 0);\n"
+	"  done();\n"
+	"}\n";
+
+int main()
+{
+	TEST_CHECK(asPrepareMultithread() >= 0);
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterFiles<AsDirectExecutor>(Engine);
+	TEST_CHECK(Engine->RegisterGlobalFunction("void done()", asFUNCTION(SetDone), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/*
+		Append ignores write offset, written arrays are copied so script may
+		change them meanwhile, special files are read until end of file
+	*/
+	asIScriptContext* Context = TestStart(Module, "void main()");
+	for (int i = 0; i < 500 && !Done; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	TEST_CHECK(Done);
+	while (Context->GetState() == asEXECUTION_ACTIVE)
+		std::this_thread::yield();
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	remove("files.bin");
+	remove("files2.bin");
+
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
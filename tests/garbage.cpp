@@ -0,0 +1,61 @@
+#include "test.hpp"
+#include <string>
+
+static const char* Code =
+	"class Node { Node@ next; }\n"
+	"void main() {\n"
+	"  for (int i = 0; i < 100; i++) {\n"
+	"    Node@ a = Node(); Node@ b = Node();\n"
+	"    @a.next = b; @b.next = a;\n"
+	"  }\n"
+	"}\n";
+
+static void Garbage(asIScriptModule* Module)
+{
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	Context->Release();
+}
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	asIScriptModule* Module = TestBuild(Engine, Code);
+	TEST_CHECK(Engine->GetEngineProperty(asEP_AUTO_GARBAGE_COLLECT) != 0);
+	{
+		/* Automatic collection is left to the loop */
+		AsGarbageScheduler Collector(Engine, 1000, 0);
+		TEST_CHECK(Engine->GetEngineProperty(asEP_AUTO_GARBAGE_COLLECT) == 0);
+		Garbage(Module);
+
+		/* Cycles are collected by idle calls, each does at least one step */
+		uint64_t Destroyed = 0;
+		for (int i = 0; i < 10000 && Destroyed < 200; i++)
+		{
+			const AsGarbageScheduler::Tick& Next = Collector.Idle(0);
+			TEST_CHECK(Next.Steps == 1 && !Next.Forced);
+			Destroyed += Next.Destroyed;
+		}
+		TEST_CHECK(Destroyed >= 200);
+		TEST_CHECK(Collector.GetCounters().Cycles > 0);
+
+		/* Threshold forces full cycle at once */
+		Collector.SetThreshold(1);
+		Garbage(Module);
+		const AsGarbageScheduler::Tick& Forced = Collector.Idle();
+		TEST_CHECK(Forced.Forced && Forced.Completed && Forced.Steps == 1);
+		TEST_CHECK(Forced.Destroyed >= 200);
+
+		/* Survivors of forced cycle do not force next one */
+		TEST_CHECK(!Collector.Idle().Forced);
+
+		std::string Text = Collector.Export();
+		TEST_CHECK(Text.find("promise_gc_forced_total 1\n") != std::string::npos);
+		TEST_CHECK(Text.find("promise_gc_ticks_total ") != std::string::npos);
+	}
+	TEST_CHECK(Engine->GetEngineProperty(asEP_AUTO_GARBAGE_COLLECT) != 0);
+
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,40 @@
+#include "test.hpp"
+
+static const char* Code =
+	"class box { int value = 3; }\n"
+	"promise<box@>@ stored;\n"
+	"void store() {\n"
+	"  @stored = promise<box@>();\n"
+	"  box@ instance = box();\n"
+	"  stored.wrap(instance);\n"
+	"}\n"
+	"void load() {\n"
+	"  box@ instance = stored.unwrap();\n"
+	"  check(instance !is null && instance.value == 3);\n"
+	"}\n";
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Stored handle keeps object alive after last script reference is gone */
+	int Status = 0;
+	asIScriptContext* Store = TestStart(Module, "void store()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	Store->Release();
+	TEST_CHECK(Engine->GarbageCollect(asGC_FULL_CYCLE) >= 0);
+
+	asIScriptContext* Load = TestStart(Module, "void load()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	Load->Release();
+
+	/* Promise and object are both freed once module is discarded */
+	Module->Discard();
+	TEST_CHECK(Engine->GarbageCollect(asGC_FULL_CYCLE) >= 0);
+	asUINT Alive = 0;
+	Engine->GetGCStatistics(&Alive);
+	TEST_CHECK(Alive == 0);
+	Engine->ShutDownAndRelease();
+	return 0;
+}
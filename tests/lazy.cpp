@@ -0,0 +1,61 @@
+#include "test.hpp"
+#include <memory>
+
+static std::shared_ptr<int> Token = std::make_shared<int>(0);
+static int Started = 0;
+
+static AsDirectPromise* Lazy(int Key, asIScriptContext* Context)
+{
+	std::shared_ptr<int> Captured = Token;
+	return AsDirectPromise::Create([Key, Captured](AsDirectPromise* Self)
+	{
+		++Started;
+		int Value = Key * 10;
+		Self->Store(&Value, asTYPEID_INT32);
+	}, Context);
+}
+static AsDirectPromise* Fetch(int Key)
+{
+	return Lazy(Key, asGetActiveContext());
+}
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ fetch(int)", asFUNCTION(Fetch), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine,
+		"int value = 0;"
+		"void main()"
+		"{"
+		"	promise<int>@ awaited = fetch(1);"
+		"	promise<int>@ speculative = fetch(2);"
+		"	value = co_await awaited;"
+		"	promise<int>@ queried = fetch(3);"
+		"	check(!queried.pending());"
+		"	value += queried.unwrap();"
+		"}");
+
+	/* Only awaited and queried promises start their producers */
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(Started == 2);
+	TEST_CHECK(TestGlobal<int>(Module, "value") == 40);
+
+	/* Promise settled by host before it was awaited never starts */
+	AsDirectPromise* Settled = Lazy(4, Context);
+	int Value = 1;
+	Settled->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(!Settled->Poll());
+	TEST_CHECK(Started == 2);
+	Settled->Release();
+
+	/* Producers of released promises are destroyed without being called */
+	Context->Release();
+	Engine->GarbageCollect();
+	TEST_CHECK(Started == 2);
+	TEST_CHECK(Token.use_count() == 1);
+
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,69 @@
+#include "test.hpp"
+
+static AsDirectPromise* Pending[2] = { nullptr, nullptr };
+
+static AsDirectPromise* CreatePending(int Index)
+{
+	Pending[Index] = AsDirectPromise::Create();
+	Pending[Index]->AddRef();
+	return Pending[Index];
+}
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending(int)", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine,
+		"int sum = 0;\n"
+		"void first() { sum += co_await pending(0); }\n"
+		"void second() { sum += co_await pending(1); }\n"
+		"void abandoned() { sum += co_await pending(0); }\n");
+
+	/* Two contexts are suspended at different sites at the same time */
+	AsPromiseMetrics& Metrics = AsPromiseMetrics::Get();
+	uint64_t Resumed = Metrics.GetCounters().Resumed.load();
+	uint64_t Resumes = Metrics.GetCounters().SettleToResume.Count.load();
+	asIScriptContext* A = TestStart(Module, "void first()");
+	asIScriptContext* B = TestStart(Module, "void second()");
+	TEST_CHECK(A->GetState() == asEXECUTION_SUSPENDED && B->GetState() == asEXECUTION_SUSPENDED);
+
+	int Value = 1;
+	Pending[1]->Store(&Value, asTYPEID_INT32);
+	Value = 2;
+	Pending[0]->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(A->GetState() == asEXECUTION_FINISHED && B->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "sum") == 3);
+
+	/* Each resume is measured once, sites on lines 2 and 3 are kept apart */
+	TEST_CHECK(Metrics.GetCounters().Resumed.load() == Resumed + 2);
+	TEST_CHECK(Metrics.GetCounters().SettleToResume.Count.load() == Resumes + 2);
+	int Sites = 0;
+	Metrics.ForEachSite([&Sites](const AsPromiseMetrics::Site& Next)
+	{
+		if (Next.Section == "test" && (Next.Line == 2 || Next.Line == 3))
+		{
+			TEST_CHECK(Next.Suspension.Count.load() == 1);
+			++Sites;
+		}
+	});
+	TEST_CHECK(Sites == 2);
+	TEST_CHECK(Metrics.Export().find("promise_await_suspension_us_count{function=") != std::string::npos);
+
+	Pending[0]->Release();
+	Pending[1]->Release();
+	A->Release();
+	B->Release();
+
+	/* Context destroyed while suspended is no longer counted as suspended */
+	uint64_t Suspended = Metrics.GetCounters().Suspended.load();
+	asIScriptContext* C = TestStart(Module, "void abandoned()");
+	TEST_CHECK(C->GetState() == asEXECUTION_SUSPENDED);
+	TEST_CHECK(Metrics.GetCounters().Suspended.load() == Suspended + 1);
+	C->Abort();
+	C->Release();
+	Pending[0]->Release();
+	Engine->GarbageCollect();
+	TEST_CHECK(Metrics.GetCounters().Suspended.load() == Suspended);
+	Engine->ShutDownAndRelease();
+	return 0;
+}
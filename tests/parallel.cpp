@@ -0,0 +1,67 @@
+#include "test.hpp"
+#include <functional>
+#include <vector>
+
+/* Pool that runs work only when asked, so test stays on one thread */
+struct ManualPool
+{
+	std::vector<std::function<void()>> Tasks;
+
+	void Enqueue(std::function<void()>&& Task)
+	{
+		Tasks.push_back(std::move(Task));
+	}
+	size_t GetThreads()
+	{
+		return 2;
+	}
+	size_t Run()
+	{
+		std::vector<std::function<void()>> Current = std::move(Tasks);
+		for (auto& Task : Current)
+			Task();
+		return Current.size();
+	}
+};
+
+static const char* Code =
+	"array<int> squares(16);\n"
+	"int calls = 0;\n"
+	"int code = 0;\n"
+	"void main() {\n"
+	"  co_await parallel_for(0, 16, function(i) { squares[i] = int(i * i); }, 4);\n"
+	"  check(squares[15] == 225);\n"
+	"  array<int> values = { 1, 2, 3, 4, 5 };\n"
+	"  array<int>@ doubled = (co_await values.parallel_map(function(v) { return v * 2; }, 2)).unwrap();\n"
+	"  check(doubled.length() == 5 && doubled[0] == 2 && doubled[4] == 10);\n"
+	"  promise_v@ failing = parallel_for(0, 8, function(i) { ++calls; if (i == 1) { array<int> empty; empty[0] = 0; } }, 2);\n"
+	"  co_await failing;\n"
+	"  code = failing.error_code();\n"
+	"}\n";
+
+int main()
+{
+	ManualPool Pool;
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterParallel<AsDirectExecutor>(Engine, Pool);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Each chunk is one pool task, last one resumes script */
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+	TEST_CHECK(Pool.Run() == 4);
+	TEST_CHECK(Context->GetState() == asEXECUTION_SUSPENDED);
+	TEST_CHECK(Pool.Run() == 3);
+
+	/* Exception stops chunks that start after it and rejects */
+	TEST_CHECK(Context->GetState() == asEXECUTION_SUSPENDED);
+	TEST_CHECK(Pool.Run() == 4);
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "calls") == 2);
+	TEST_CHECK(TestGlobal<int>(Module, "code") == PROMISE_PARALLEL_ERROR);
+
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,89 @@
+#include "test.hpp"
+#include <vector>
+
+static std::vector<AsPolymorphicPromise*> Pending;
+static std::vector<AsPolymorphicPromise*> Queue;
+static int CustomResumes = 0;
+
+static AsPolymorphicPromise* CreatePending()
+{
+	AsPolymorphicPromise* Promise = AsPolymorphicPromise::Create();
+	Promise->AddRef();
+	Pending.push_back(Promise);
+	return Promise;
+}
+static void ResumeCustom(AsPolymorphicPromise* Target, asIScriptContext* Context)
+{
+	++CustomResumes;
+	AsDirectExecutor()(Target, Context);
+}
+static void ExecuteCustom(AsPolymorphicPromise* Target, asIScriptContext* Context, asIScriptFunction* Callback)
+{
+	AsDirectExecutor()(Target, Context, Callback);
+}
+static asIScriptContext* Start(asIScriptModule* Module, uint8_t Tag)
+{
+	asIScriptContext* Context = Module->GetEngine()->CreateContext();
+	TEST_CHECK(Context->Prepare(Module->GetFunctionByDecl("void main()")) >= 0);
+	AsPolymorphicExecutor::SetPolicy(Context, Tag);
+	TEST_CHECK(AsExecuteContext(Context) == asEXECUTION_SUSPENDED);
+	return Context;
+}
+
+int main()
+{
+	AsPolymorphicExecutor::ReactiveCallback Notify = [](AsPolymorphicPromise* Target, asIScriptFunction* Callback)
+	{
+		TEST_CHECK(Callback == nullptr);
+		Queue.push_back(Target);
+	};
+	AsPolymorphicExecutor::SetPolicy(AsPolymorphicExecutor::Custom, &ResumeCustom, &ExecuteCustom);
+	TEST_CHECK(AsPolymorphicExecutor::HasPolicy(AsPolymorphicExecutor::Custom));
+	TEST_CHECK(!AsPolymorphicExecutor::HasPolicy(AsPolymorphicExecutor::Custom + 1));
+
+	asIScriptEngine* Engine = TestEngine<AsPolymorphicExecutor>();
+	AsPolymorphicExecutor::SetCallback(Engine, &Notify);
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending()", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, "int value = 0; void main() { value += co_await pending(); }");
+	int* Value = &TestGlobal<int>(Module, "value");
+
+	/* Promise inherits policy of it's context */
+	asIScriptContext* Direct = Start(Module, AsPolymorphicExecutor::Direct);
+	asIScriptContext* Reactive = Start(Module, AsPolymorphicExecutor::Reactive);
+	asIScriptContext* Custom = Start(Module, AsPolymorphicExecutor::Direct);
+	TEST_CHECK(Pending.size() == 3);
+	TEST_CHECK(Pending[0]->GetExecutorTag() == AsPolymorphicExecutor::Direct);
+	TEST_CHECK(Pending[1]->GetExecutorTag() == AsPolymorphicExecutor::Reactive);
+	TEST_CHECK(Pending[2]->GetExecutorTag() == AsPolymorphicExecutor::Direct);
+
+	/* Direct resumes in place */
+	int Number = 1;
+	Pending[0]->Store(&Number, asTYPEID_INT32);
+	TEST_CHECK(Direct->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(*Value == 1);
+
+	/* Reactive only queues, loop resumes the awaiting context */
+	Number = 10;
+	Pending[1]->Store(&Number, asTYPEID_INT32);
+	TEST_CHECK(Queue.size() == 1 && Queue[0] == Pending[1]);
+	TEST_CHECK(Reactive->GetState() == asEXECUTION_SUSPENDED);
+	TEST_CHECK(AsExecuteContext(Queue[0]->GetContext()) == asEXECUTION_FINISHED);
+	TEST_CHECK(*Value == 11);
+
+	/* Retagged promise goes through custom policy */
+	Pending[2]->SetExecutorTag(AsPolymorphicExecutor::Custom);
+	Number = 100;
+	Pending[2]->Store(&Number, asTYPEID_INT32);
+	TEST_CHECK(CustomResumes == 1);
+	TEST_CHECK(Custom->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(*Value == 111);
+
+	for (auto* Promise : Pending)
+		Promise->Release();
+	Direct->Release();
+	Reactive->Release();
+	Custom->Release();
+	AsPolymorphicExecutor::SetCallback(Engine, nullptr);
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,59 @@
+#include "test.hpp"
+
+static const char* Code =
+	"int code = 0;\n"
+	"int killed = 0;\n"
+	"void main(array<string>@ args, array<uint8>@ data) {\n"
+	"  uint length = data.length();\n"
+	"  uint8 first = data[0];\n"
+	"  promise<process_result@>@ pending = run(\"sh\", args, data);\n"
+	"  data.resize(0);\n"
+	"  process_result@ result = co_await pending;\n"
+	"  code = result.exit_code();\n"
+	"  array<uint8>@ output = result.output();\n"
+	"  check(output.length() == length && output[0] == first);\n"
+	"  check(result.error_output().length() == 4);\n"
+	"  async_process@ child = spawn_process(\"sleep\", { \"10\" });\n"
+	"  check(child !is null && child.kill());\n"
+	"  killed = co_await child.wait();\n"
+	"  check(!child.kill());\n"
+	"  promise<process_result@>@ missing = run(\"/nonexistent/command\");\n"
+	"  check(missing.failed());\n"
+	"}\n";
+
+int main()
+{
+	AsReactor* Reactor = new AsReactor();
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterProcesses<AsDirectExecutor>(Engine, Reactor);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Arguments are passed by host so their references can be counted */
+	CScriptArray* Args = CScriptArray::Create(Engine->GetTypeInfoByDecl("array<string>"), 2);
+	*(std::string*)Args->At(0) = "-c";
+	*(std::string*)Args->At(1) = "cat; echo err >&2; exit 3";
+	CScriptArray* Data = AsCreateByteArray(Engine, 3);
+	memcpy(Data->GetBuffer(), "abc", 3);
+
+	asIScriptContext* Context = Engine->CreateContext();
+	TEST_CHECK(Context->Prepare(Module->GetFunctionByDecl("void main(array<string>@, array<uint8>@)")) >= 0);
+	TEST_CHECK(Context->SetArgObject(0, Args) >= 0);
+	TEST_CHECK(Context->SetArgObject(1, Data) >= 0);
+	AsExecuteContext(Context);
+	for (int i = 0; i < 1000 && IsAsyncContextBusy(Context); i++)
+		Reactor->Dispatch(10);
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "code") == 3);
+	TEST_CHECK(TestGlobal<int>(Module, "killed") == -SIGTERM);
+
+	/* Argument arrays are not leaked by run */
+	Context->Release();
+	TEST_CHECK(Args->GetRefCount() == 1);
+	TEST_CHECK(Data->GetRefCount() == 1);
+
+	Args->Release();
+	Data->Release();
+	delete Reactor;
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,102 @@
+#include "test.hpp"
+#include <atomic>
+#include <set>
+#include <string>
+#include <vector>
+
+static AsDirectPromise* Pending = nullptr;
+
+static AsDirectPromise* CreatePending()
+{
+	Pending = AsDirectPromise::Create();
+	Pending->AddRef();
+	return Pending;
+}
+
+static size_t Find(AsPromiseRegistry::Snapshot* Result)
+{
+	size_t Count = 0;
+	AsPromiseRegistry::Get().Enumerate([&Count, Result](const AsPromiseRegistry::Snapshot& Next)
+	{
+		if (Next.Promise != (void*)Pending)
+			return;
+
+		*Result = Next;
+		++Count;
+	});
+	return Count;
+}
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending()", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, "int value = 0; void main() { value = co_await pending(); }");
+
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+
+	/* Watchdog reports stalled promise once */
+	std::atomic<int> Reports(0);
+	{
+		AsPromiseWatchdog Watchdog(0, 5, [&Reports](const AsPromiseRegistry::Snapshot& Next)
+		{
+			if (Next.Promise == (void*)Pending)
+				++Reports;
+		});
+		for (int i = 0; i < 1000 && Reports == 0; i++)
+			std::this_thread::sleep_for(std::chrono::milliseconds(5));
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	}
+	TEST_CHECK(Reports == 1);
+
+	/* Suspended context is inspected with it's stack */
+	AsPromiseRegistry::Snapshot Next;
+	TEST_CHECK(Find(&Next) == 1);
+	TEST_CHECK(Next.Context == Context);
+	TEST_CHECK(Next.Created.find("main") != std::string::npos);
+	TEST_CHECK(Next.Awaited.find("main") != std::string::npos);
+	TEST_CHECK(Next.Stack.find("main") != std::string::npos);
+
+	/* Destroyed context is forgotten, recorded functions outlive discarded module */
+	Context->Abort();
+	Context->Release();
+	Module->Discard();
+	Engine->GarbageCollect();
+	Next = AsPromiseRegistry::Snapshot();
+	TEST_CHECK(Find(&Next) == 1);
+	TEST_CHECK(Next.Context == nullptr);
+	TEST_CHECK(Next.Stack.empty());
+	TEST_CHECK(Next.Awaited.find("main") != std::string::npos);
+
+	/* Slot is freed with the promise */
+	Pending->Release();
+	Engine->GarbageCollect();
+	TEST_CHECK(Find(&Next) == 0);
+
+	/* Freed slots are reused before the shard grows */
+	static AsPromiseRegistry Local;
+	AsPromiseRegistry* Registry = &Local;
+	std::vector<AsPromiseRegistry::Slot*> Slots;
+	for (size_t i = 0; i < PROMISE_REGISTRY_CHUNK * 3; i++)
+		Slots.push_back(Registry->Insert((void*)(i + 1), nullptr));
+	TEST_CHECK(Registry->Enumerate([](const AsPromiseRegistry::Snapshot&) { }) == Slots.size());
+	std::set<AsPromiseRegistry::Slot*> Used(Slots.begin(), Slots.end());
+	for (auto* Slot : Slots)
+		Registry->Remove(Slot);
+	TEST_CHECK(Registry->Enumerate([](const AsPromiseRegistry::Snapshot&) { }) == 0);
+	for (size_t i = 0; i < Slots.size(); i++)
+		TEST_CHECK(Used.count(Registry->Insert((void*)(i + 1), nullptr)) == 1);
+
+	/* Long locations are not truncated */
+	Next = AsPromiseRegistry::Snapshot();
+	Next.Created = std::string(300, 'c');
+	Next.Awaited = std::string(300, 'a');
+	std::string Line = AsPromiseRegistry::Format(Next);
+	TEST_CHECK(Line.find(Next.Created) != std::string::npos);
+	TEST_CHECK(Line.find(Next.Awaited + "\n") != std::string::npos);
+
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,62 @@
+#include "test.hpp"
+
+static AsDirectPromise* Pending = nullptr;
+
+static AsDirectPromise* CreatePending()
+{
+	Pending = AsDirectPromise::Create();
+	Pending->AddRef();
+	return Pending;
+}
+
+static const char* Code =
+	"int value = 0;\n"
+	"int code = 0;\n"
+	"string detail;\n"
+	"bool thrown = false;\n"
+	"void main() {\n"
+	"  promise<int>@ result = pending();\n"
+	"  value = (co_await result).unwrap_or(-1);\n"
+	"  check(result.failed());\n"
+	"  code = result.error_code();\n"
+	"  check(result.error_detail(detail));\n"
+	"  try { result.unwrap(); } catch { thrown = true; }\n"
+	"}\n"
+	"void local() {\n"
+	"  promise<int>@ result = promise<int>();\n"
+	"  result.reject(7);\n"
+	"  check(result.failed() && result.error_code() == 7);\n"
+	"  check(result.unwrap_or(3) == 3);\n"
+	"}\n";
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending()", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Rejection from host resumes awaiting context without exception */
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+
+	std::string Detail = "not found";
+	int DetailTypeId = Engine->GetTypeIdByDecl("string");
+	Pending->Reject(404, &Detail, DetailTypeId);
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(Pending->IsFailed() && Pending->GetErrorCode() == 404);
+	TEST_CHECK(TestGlobal<int>(Module, "value") == -1);
+	TEST_CHECK(TestGlobal<int>(Module, "code") == 404);
+	TEST_CHECK(TestGlobal<std::string>(Module, "detail") == "not found");
+	TEST_CHECK(TestGlobal<bool>(Module, "thrown"));
+
+	/* Rejection within script */
+	asIScriptContext* Local = TestStart(Module, "void local()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+
+	Local->Release();
+	Pending->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
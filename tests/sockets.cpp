@@ -0,0 +1,79 @@
+#include "test.hpp"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+static const char* Code =
+	"bool exchanged = false;\n"
+	"async_socket@ idle;\n"
+	"promise<async_socket@>@ waiting;\n"
+	"void main(const string&in address) {\n"
+	"  async_socket@ server = listen(address);\n"
+	"  check(server !is null);\n"
+	"  promise<async_socket@>@ accepted = server.accept();\n"
+	"  async_socket@ client = co_await connect(address);\n"
+	"  async_socket@ peer = co_await accepted;\n"
+	"  check(client !is null && peer !is null);\n"
+	"  array<uint8> request = { 1, 2, 3 };\n"
+	"  promise<uint>@ writing = client.write(request);\n"
+	"  request.resize(0);\n"
+	"  uint written = co_await writing;\n"
+	"  check(written == 3);\n"
+	"  array<uint8>@ data = co_await peer.read(16);\n"
+	"  check(data.length() == 3 && data[2] == 3);\n"
+	"  client.close();\n"
+	"  @data = co_await peer.read(16);\n"
+	"  check(data.length() == 0);\n"
+	"  peer.close();\n"
+	"  exchanged = true;\n"
+	"  @idle = server;\n"
+	"  @waiting = idle.accept();\n"
+	"}\n"
+	"void cancelled() {\n"
+	"  check(waiting.failed() && !idle.is_open());\n"
+	"}\n";
+
+/* Free loopback address, port is taken from kernel */
+static std::string GetLoopback()
+{
+	sockaddr_in Address;
+	memset(&Address, 0, sizeof(Address));
+	Address.sin_family = AF_INET;
+	Address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t Size = sizeof(Address);
+	int Fd = socket(AF_INET, SOCK_STREAM, 0);
+	TEST_CHECK(Fd >= 0);
+	TEST_CHECK(bind(Fd, (sockaddr*)&Address, Size) == 0);
+	TEST_CHECK(getsockname(Fd, (sockaddr*)&Address, &Size) == 0);
+	close(Fd);
+	return "127.0.0.1:" + std::to_string(ntohs(Address.sin_port));
+}
+
+int main()
+{
+	AsReactor* Reactor = new AsReactor();
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterSockets<AsDirectExecutor>(Engine, Reactor);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Every await is settled by reactor events on this thread */
+	std::string Address = GetLoopback();
+	asIScriptContext* Context = Engine->CreateContext();
+	TEST_CHECK(Context->Prepare(Module->GetFunctionByDecl("void main(const string&in)")) >= 0);
+	TEST_CHECK(Context->SetArgObject(0, &Address) >= 0);
+	AsExecuteContext(Context);
+	for (int i = 0; i < 1000 && IsAsyncContextBusy(Context); i++)
+		Reactor->Dispatch(10);
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<bool>(Module, "exchanged"));
+
+	/* Reactor closes sockets that are still attached, pending accept is cancelled */
+	delete Reactor;
+	asIScriptContext* Cancelled = TestStart(Module, "void cancelled()");
+	TEST_CHECK(Cancelled->GetState() == asEXECUTION_FINISHED);
+
+	Cancelled->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,48 @@
+#include "test.hpp"
+
+static const char* Code =
+	"int result = 0;\n"
+	"int total = 0;\n"
+	"void waiter(promise<int>@ value) { result = co_await value; }\n"
+	"void add(int value) { total += value; }\n"
+	"void main() {\n"
+	"  promise<int>@ value = promise<int>();\n"
+	"  promise_v@ done = spawn(waiter, value);\n"
+	"  check(done.pending() && value.pending());\n"
+	"  value.wrap(5);\n"
+	"  co_await done;\n"
+	"  check(result == 5 && !done.failed());\n"
+	"  task_group@ group = task_group(1);\n"
+	"  group.spawn(add, 1);\n"
+	"  group.spawn(add, 2);\n"
+	"  co_await group.join();\n"
+	"  check(total == 3);\n"
+	"}\n"
+	"int twice(int value) { return value * 2; }\n"
+	"void returning() { spawn(twice, 1); }\n";
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterTasks<AsDirectExecutor>(Engine);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/*
+		Promise created by main context is awaited by spawned function,
+		awaiting rebinds it to pooled context so settling resumes waiter
+		instead of suspending main context
+	*/
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "result") == 5);
+	TEST_CHECK(TestGlobal<int>(Module, "total") == 3);
+	Context->Release();
+
+	/* Return value could not be delivered, so such functions are refused */
+	Context = TestStart(Module, "void returning()", &Status);
+	TEST_CHECK(Status == asEXECUTION_EXCEPTION);
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
@@ -0,0 +1,80 @@
+#include "test.hpp"
+
+static const char* Code =
+	"async_mutex@ mutex = async_mutex();\n"
+	"async_semaphore@ limit = async_semaphore(1);\n"
+	"async_event@ ready = async_event();\n"
+	"async_barrier@ barrier = async_barrier(2);\n"
+	"int64 trace = 0;\n"
+	"void worker(int id) {\n"
+	"  co_await mutex.lock();\n"
+	"  co_await limit.acquire();\n"
+	"  check(limit.permits() == 0 && mutex.locked());\n"
+	"  trace = trace * 100 + id;\n"
+	"  co_await ready.wait();\n"
+	"  limit.release();\n"
+	"  mutex.unlock();\n"
+	"  co_await barrier.arrive_and_wait();\n"
+	"  trace = trace * 100 + id + 10;\n"
+	"}\n"
+	"void first() { worker(1); }\n"
+	"void second() { worker(2); }\n"
+	"void signal() { ready.set(); }\n"
+	"void unlock_free() { async_mutex().unlock(); }\n"
+	"void empty_barrier() { async_barrier(0); }\n"
+	"bool cancelled = false;\n"
+	"void orphan() {\n"
+	"  async_mutex@ held = async_mutex();\n"
+	"  check(held.try_lock());\n"
+	"  promise_v@ waiter = held.lock();\n"
+	"  @held = null;\n"
+	"  cancelled = waiter.failed();\n"
+	"}\n";
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	AsRegisterSynchronization<AsDirectExecutor>(Engine);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* First worker owns the mutex and waits for event, second waits for the mutex */
+	int Status = 0;
+	asIScriptContext* First = TestStart(Module, "void first()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+	asIScriptContext* Second = TestStart(Module, "void second()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+	TEST_CHECK(TestGlobal<asINT64>(Module, "trace") == 1);
+
+	/* Event wakes first, unlock hands mutex to second, barrier releases both */
+	asIScriptContext* Signal = TestStart(Module, "void signal()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(First->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(Second->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<asINT64>(Module, "trace") == 1021211);
+
+	/* Misuse raises script exceptions, destroyed primitive cancels it's waiters */
+	asIScriptContext* Misuse = TestStart(Module, "void unlock_free()", &Status);
+	TEST_CHECK(Status == asEXECUTION_EXCEPTION);
+	Misuse->Release();
+	Misuse = TestStart(Module, "void empty_barrier()", &Status);
+	TEST_CHECK(Status == asEXECUTION_EXCEPTION);
+	Misuse->Release();
+	Misuse = TestStart(Module, "void orphan()", &Status);
+	TEST_CHECK(Status == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<bool>(Module, "cancelled"));
+	Misuse->Release();
+
+	/* Host side of semaphore is usable without context */
+	AsAsyncSemaphore<AsDirectExecutor>* Semaphore = AsAsyncSemaphore<AsDirectExecutor>::Create(1);
+	TEST_CHECK(Semaphore->TryAcquire());
+	TEST_CHECK(!Semaphore->TryAcquire());
+	Semaphore->Signal();
+	TEST_CHECK(Semaphore->GetPermits() == 1);
+	Semaphore->Release();
+
+	Signal->Release();
+	Second->Release();
+	First->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
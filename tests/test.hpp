@@ -0,0 +1,87 @@
+/*
+	Minimal harness shared by tests, each test is a standalone executable
+	that returns non-zero (and prints failed check) on failure
+*/
+#ifndef AS_PROMISE_TEST_HPP
+#define AS_PROMISE_TEST_HPP
+#include "config.hpp"
+#include <angelscript.h>
+#include <scriptarray/scriptarray.h>
+#include <scriptstdstring/scriptstdstring.h>
+#include "../src/aspromise.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+
+/* Check that is not compiled out by NDEBUG */
+#define TEST_CHECK(Expression) ((Expression) ? (void)0 : TestFail(#Expression, __FILE__, __LINE__))
+
+static void TestFail(const char* Expression, const char* File, int Line)
+{
+	fprintf(stderr, "%s(%i): check failed: %s\n", File, Line, Expression);
+	exit(1);
+}
+/* Compiler messages */
+static void TestLog(const asSMessageInfo* Message, void*)
+{
+	static const char* Level[3] = { "err", "warn", "info" };
+	fprintf(stderr, "[%s] %s(%i,%i): %s\n", Level[(uint32_t)Message->type], Message->section, Message->row, Message->col, Message->message);
+}
+/* Script side check, reports line of failed script check */
+static void TestScriptCheck(bool Value)
+{
+	if (Value)
+		return;
+
+	asIScriptContext* Context = asGetActiveContext();
+	const char* Section = nullptr;
+	int Line = Context ? Context->GetLineNumber(0, nullptr, &Section) : 0;
+	TestFail("script check", Section ? Section : "?", Line);
+}
+/* Engine with string and array add-ons, promise interface of executor and check(bool) */
+template <typename Executor>
+static asIScriptEngine* TestEngine()
+{
+	asIScriptEngine* Engine = asCreateScriptEngine();
+	TEST_CHECK(Engine != nullptr);
+	TEST_CHECK(Engine->SetMessageCallback(asFUNCTION(TestLog), 0, asCALL_CDECL) >= 0);
+	RegisterStdString(Engine);
+	RegisterScriptArray(Engine, true);
+	AsBasicPromise<Executor>::Register(Engine);
+	TEST_CHECK(Engine->RegisterGlobalFunction("void check(bool)", asFUNCTION(TestScriptCheck), asCALL_CDECL) >= 0);
+	return Engine;
+}
+/* Build a module from code with <co_await> syntax */
+static asIScriptModule* TestBuild(asIScriptEngine* Engine, const char* Code, const char* Name = "test")
+{
+	size_t Size = strlen(Code);
+	char* Generated = AsGeneratePromiseEntrypoints(Code, &Size);
+	asIScriptModule* Module = Engine->GetModule(Name, asGM_ALWAYS_CREATE);
+	TEST_CHECK(Module->AddScriptSection(Name, Generated, Size) >= 0);
+	asFreeMem(Generated);
+	TEST_CHECK(Module->Build() >= 0);
+	return Module;
+}
+/* Start a function of module on a new context, returns context that should be released by caller */
+static asIScriptContext* TestStart(asIScriptModule* Module, const char* Declaration, int* Status = nullptr)
+{
+	asIScriptFunction* Function = Module->GetFunctionByDecl(Declaration);
+	TEST_CHECK(Function != nullptr);
+
+	asIScriptContext* Context = Module->GetEngine()->CreateContext();
+	TEST_CHECK(Context->Prepare(Function) >= 0);
+	int Result = AsExecuteContext(Context);
+	if (Status != nullptr)
+		*Status = Result;
+	return Context;
+}
+/* Address of global variable of module */
+template <typename T>
+static T& TestGlobal(asIScriptModule* Module, const char* Name)
+{
+	int Index = Module->GetGlobalVarIndexByName(Name);
+	TEST_CHECK(Index >= 0);
+	return *(T*)Module->GetAddressOfGlobalVar((asUINT)Index);
+}
+#endif
@@ -0,0 +1,60 @@
+#include "test.hpp"
+#include <vector>
+
+static AsDirectPromise* Pending = nullptr;
+
+static AsDirectPromise* CreatePending()
+{
+	Pending = AsDirectPromise::Create();
+	Pending->AddRef();
+	return Pending;
+}
+
+int main()
+{
+	asIScriptEngine* Engine = TestEngine<AsDirectExecutor>();
+	TEST_CHECK(Engine->RegisterGlobalFunction("promise<int>@ pending()", asFUNCTION(CreatePending), asCALL_CDECL) >= 0);
+	asIScriptModule* Module = TestBuild(Engine, "int value = 0; void main() { value = co_await pending(); }");
+
+	/* Discard events of other promises, if any */
+	AsPromiseTracer::Drain([](const AsPromiseTracer::Record&) { });
+
+	int Status = 0;
+	asIScriptContext* Context = TestStart(Module, "void main()", &Status);
+	TEST_CHECK(Status == asEXECUTION_SUSPENDED);
+
+	int Value = 42;
+	Pending->Store(&Value, asTYPEID_INT32);
+	TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+	TEST_CHECK(TestGlobal<int>(Module, "value") == 42);
+
+	/* Lifecycle of awaited promise is recorded in order */
+	std::vector<AsPromiseTracer::Event> Events;
+	uint64_t Dropped = AsPromiseTracer::Drain([&Events](const AsPromiseTracer::Record& Next)
+	{
+		if (Next.PromiseId == (uint64_t)(uintptr_t)Pending)
+			Events.push_back(Next.Type);
+	});
+	TEST_CHECK(Dropped == 0);
+	TEST_CHECK(Events.size() >= 4);
+	TEST_CHECK(Events[0] == AsPromiseTracer::Event::Create);
+	TEST_CHECK(Events[1] == AsPromiseTracer::Event::Suspend);
+	TEST_CHECK(Events[2] == AsPromiseTracer::Event::Store);
+	TEST_CHECK(Events[3] == AsPromiseTracer::Event::Resume);
+
+	/* Flushed file is chrome trace json */
+	AsPromiseTracer::Push(AsPromiseTracer::Event::Callback, Pending, Context);
+	TEST_CHECK(AsPromiseTracer::Flush("tracing.json"));
+	FILE* Stream = fopen("tracing.json", "rb");
+	TEST_CHECK(Stream != nullptr);
+	char Header[32] = { 0 };
+	TEST_CHECK(fread(Header, 1, sizeof(Header) - 1, Stream) > 0);
+	fclose(Stream);
+	remove("tracing.json");
+	TEST_CHECK(strstr(Header, "traceEvents") != nullptr);
+
+	Pending->Release();
+	Context->Release();
+	Engine->ShutDownAndRelease();
+	return 0;
+}
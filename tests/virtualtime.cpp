@@ -0,0 +1,80 @@
+#include "test.hpp"
+#include <string>
+
+static const char* Code =
+	"string order;\n"
+	"void worker(const string&in id, uint64 delay) {\n"
+	"  uint64 start = virtual_time();\n"
+	"  co_await sleep(delay);\n"
+	"  check(virtual_time() == start + delay);\n"
+	"  order += id;\n"
+	"}\n"
+	"int fired = 0;\n"
+	"void listen() {\n"
+	"  sleep(5).when(function(value) { fired++; });\n"
+	"}\n";
+
+static asIScriptContext* Start(asIScriptModule* Module, const std::string& Id, asQWORD Delay)
+{
+	asIScriptContext* Context = Module->GetEngine()->CreateContext();
+	TEST_CHECK(Context->Prepare(Module->GetFunctionByDecl("void worker(const string&in, uint64)")) >= 0);
+	TEST_CHECK(Context->SetArgObject(0, (void*)&Id) >= 0);
+	TEST_CHECK(Context->SetArgQWord(1, Delay) >= 0);
+	TEST_CHECK(AsExecuteContext(Context) == asEXECUTION_SUSPENDED);
+	return Context;
+}
+/* Order in which timers of the same deadline fire */
+static std::string Interleave(uint64_t Seed)
+{
+	AsVirtualClock Clock(Seed);
+	std::string Order;
+	for (char Id = 'a'; Id <= 'h'; Id++)
+		Clock.Schedule(10, [&Order, Id]() { Order += Id; });
+	Clock.Run();
+	return Order;
+}
+
+int main()
+{
+	AsVirtualClock Clock;
+	asIScriptEngine* Engine = TestEngine<AsVirtualTimeExecutor>();
+	AsRegisterVirtualTime<AsVirtualTimeExecutor>(Engine, &Clock);
+	asIScriptModule* Module = TestBuild(Engine, Code);
+
+	/* Hours of sleeps complete instantly in deadline order */
+	asIScriptContext* Contexts[3] =
+	{
+		Start(Module, "a", 3600 * 1000),
+		Start(Module, "b", 1000),
+		Start(Module, "c", 60 * 1000)
+	};
+	TEST_CHECK(Clock.Run(60 * 1000) > 0);
+	TEST_CHECK(Clock.GetTime() == 60 * 1000);
+	TEST_CHECK(TestGlobal<std::string>(Module, "order") == "bc");
+	TEST_CHECK(Contexts[0]->GetState() == asEXECUTION_SUSPENDED);
+	TEST_CHECK(Clock.Run() > 0);
+	TEST_CHECK(!Clock.HasWork());
+	TEST_CHECK(Clock.GetTime() == 3600 * 1000);
+	TEST_CHECK(TestGlobal<std::string>(Module, "order") == "bca");
+	for (auto* Context : Contexts)
+	{
+		TEST_CHECK(Context->GetState() == asEXECUTION_FINISHED);
+		Context->Release();
+	}
+
+	/* Callback runs on it's own context after creating context is gone */
+	asIScriptContext* Listener = Engine->CreateContext();
+	TEST_CHECK(Listener->Prepare(Module->GetFunctionByDecl("void listen()")) >= 0);
+	TEST_CHECK(AsExecuteContext(Listener) == asEXECUTION_FINISHED);
+	Listener->Release();
+	TEST_CHECK(Clock.Run() > 0);
+	TEST_CHECK(TestGlobal<int>(Module, "fired") == 1);
+
+	/* Zero seed keeps FIFO order, same seed reproduces same interleaving */
+	TEST_CHECK(Interleave(0) == "abcdefgh");
+	TEST_CHECK(Interleave(7) == Interleave(7));
+	TEST_CHECK(Interleave(7) != "abcdefgh" || Interleave(11) != "abcdefgh");
+
+	Engine->ShutDownAndRelease();
+	return 0;
+}